@@ -2,6 +2,10 @@
 // Author: Emil Stefanov
 // Date: 03/28/06
 // Implementaton is as described in http://en.wikipedia.org/wiki/Disjoint-set_data_structure
+// The nodes are stored as flat parent/rank arrays so that one instance can be reset and reused.
+
+#ifndef disjoint_set_h
+#define disjoint_set_h
 
 #include <vector>
 
@@ -13,35 +17,34 @@ public:
     DisjointSets();
     // Create a DisjointSets data structure with a specified number of elements (with element id's from 0 to count-1)
     DisjointSets(int count);
-    // Copy constructor
-    DisjointSets(const DisjointSets & s);
-    // Destructor
-    ~DisjointSets();
     
     // Find the set identifier that an element currently belongs to.
     // Note: some internal data is modified for optimization even though this method is consant.
     int FindSet(int element) const;
-    // Combine two sets into one. All elements in those two sets will share the same set id that can be gotten using FindSet.
-    void Union(int setId1, int setId2);
+    // Combine the sets containing the two elements into one. All elements in those two sets will share the same set id that can be gotten using FindSet.
+    void Union(int element1, int element2);
     // Add a specified number of elements to the DisjointSets data structure. The element id's of the new elements are numbered
     // consequitively starting with the first never-before-used elementId.
     void AddElements(int numToAdd);
+    // Make the data structure hold count elements, each in its own set. Previously allocated memory is kept.
+    void Reset(int count);
+    // Fill setIds so that setIds[element] is the index of the element's set, where sets are numbered
+    // 0 to NumSets()-1 in the order of their first element. Returns the number of sets.
+    int CompactSetIds(std::vector<int>& setIds) const;
     // Returns the number of elements currently in the DisjointSets data structure.
     int NumElements() const;
     // Returns the number of sets currently in the DisjointSets data structure.
     int NumSets() const;
+    // Returns the number of bytes of memory reserved for the elements (which Reset() doesn't free).
+    size_t ReservedBytes() const;
     
 private:
     
-    // Internal Node data structure used for representing an element
-    struct Node
-    {
-        int rank; // This roughly represent the max height of the node in its subtree
-        int index; // The index of the element the node represents
-        Node* parent; // The parent node of the node
-    };
-    
     int m_numElements; // the number of elements currently in the DisjointSets data structure.
     int m_numSets; // the number of sets currently in the DisjointSets data structure.
-    std::vector<Node*> m_nodes; // the list of nodes representing the elements
-};
\ No newline at end of file
+    mutable std::vector<int> m_parent; // the parent of each element (roots are their own parent)
+    std::vector<int> m_rank; // roughly the max height of each element's subtree
+    mutable std::vector<int> m_compactIds; // scratch space for CompactSetIds
+};
+
+#endif /* disjoint_set_h */
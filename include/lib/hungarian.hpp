@@ -2,25 +2,96 @@
 #define hungarian_h
 
 #include <vector>
+#include <memory>
 #include <iostream>
 #include <limits>
 #include <time.h>
 // http://community.topcoder.com/tc?module=Static&d1=tutorials&d2=hungarianAlgorithm
 using namespace std;
+// --------------------------------------------------------------------------
+// Scratch memory for solving problems with costs of type T. Once it has seen
+// the largest problem, solving doesn't touch the heap. A caller can keep one
+// per thread and share a single solver.
+// --------------------------------------------------------------------------
+template <typename T>
+struct AssignmentWorkspace
+{
+    // The assignment being built.
+    vector<int> assignment;
+    // Munkres reduces a column-major copy of the costs in place.
+    vector<T> distMatrix;
+    // Holds the covered columns, covered rows, star, prime and new star matrices back to back.
+    unique_ptr<bool[]> bools;
+    size_t boolsSize;
+    // A row-major copy of the costs for Jonker-Volgenant and the auction, only used
+    // when they can't be read in place.
+    vector<T> rowMajorCosts;
+    // Jonker-Volgenant: the column prices, the shortest path distances, the row and
+    // column solutions, the path predecessors, and the order in which columns are scanned.
+    vector<T> jvPrices;
+    vector<T> jvDistances;
+    vector<int> jvRowSolution;
+    vector<int> jvColSolution;
+    vector<int> jvPred;
+    vector<int> jvColList;
+    // Auction: the column prices, the column of each row and row of each column, the
+    // rows bidding in this round and the next, the column and amount of each bid, and
+    // the best bid and bidder for each column.
+    vector<T> auctionPrices;
+    vector<int> auctionRowSolution;
+    vector<int> auctionColSolution;
+    vector<int> auctionBidders;
+    vector<int> auctionNextBidders;
+    vector<int> auctionBidColumn;
+    vector<T> auctionBid;
+    vector<T> auctionBestBid;
+    vector<int> auctionBestBidder;
+    
+    AssignmentWorkspace() : boolsSize(0) {}
+    
+    // The number of bytes held by the buffers.
+    size_t reservedBytes() const
+    {
+        return (assignment.capacity() + jvRowSolution.capacity() + jvColSolution.capacity()
+                + jvPred.capacity() + jvColList.capacity()) * sizeof(int)
+            + (auctionRowSolution.capacity() + auctionColSolution.capacity() + auctionBidders.capacity()
+               + auctionNextBidders.capacity() + auctionBidColumn.capacity() + auctionBestBidder.capacity()) * sizeof(int)
+            + (distMatrix.capacity() + rowMajorCosts.capacity() + jvPrices.capacity() + jvDistances.capacity()) * sizeof(T)
+            + (auctionPrices.capacity() + auctionBid.capacity() + auctionBestBid.capacity()) * sizeof(T)
+            + boolsSize * sizeof(bool);
+    }
+};
+
 class AssignmentProblemSolver
 {
 private:
+    // --------------------------------------------------------------------------
+    // Buffers kept between calls so that, once the solver has seen its largest
+    // problem, solving doesn't touch the heap. distInBuffer is the column-major
+    // copy of a vector<vector<double> > problem.
+    // --------------------------------------------------------------------------
+    vector<double> distInBuffer;
+    AssignmentWorkspace<double> workspace;
+    // How far from optimal each row of an auction may end up.
+    double auctionTolerance;
     // --------------------------------------------------------------------------
     // Computes the optimal assignment (minimum overall costs) using Munkres algorithm.
     // --------------------------------------------------------------------------
-    void assignmentoptimal(int *assignment, double *cost, double *distMatrix, int nOfRows, int nOfColumns);
+    template <typename T>
+    void assignmentoptimal(int *assignment, T *cost, const T *distMatrixIn, size_t rowStride, size_t colStride, int nOfRows, int nOfColumns, AssignmentWorkspace<T>& workspace);
     void buildassignmentvector(int *assignment, bool *starMatrix, int nOfRows, int nOfColumns);
-    void computeassignmentcost(int *assignment, double *cost, double *distMatrix, int nOfRows);
-    void step2a(int *assignment, double *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim);
-    void step2b(int *assignment, double *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim);
-    void step3 (int *assignment, double *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim);
-    void step4 (int *assignment, double *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim, int row, int col);
-    void step5 (int *assignment, double *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim);
+    template <typename T>
+    void computeassignmentcost(int *assignment, T *cost, const T *distMatrix, size_t rowStride, size_t colStride, int nOfRows);
+    template <typename T>
+    void step2a(int *assignment, T *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim);
+    template <typename T>
+    void step2b(int *assignment, T *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim);
+    template <typename T>
+    void step3 (int *assignment, T *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim);
+    template <typename T>
+    void step4 (int *assignment, T *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim, int row, int col);
+    template <typename T>
+    void step5 (int *assignment, T *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim);
     // --------------------------------------------------------------------------
     // Computes a suboptimal solution. Good for cases with many forbidden assignments.
     // --------------------------------------------------------------------------
@@ -29,11 +100,83 @@ private:
     // Computes a suboptimal solution. Good for cases with many forbidden assignments.
     // --------------------------------------------------------------------------
     void assignmentsuboptimal2(int *assignment, double *cost, double *distMatrixIn, int nOfRows, int nOfColumns);
+    // --------------------------------------------------------------------------
+    // Computes the optimal assignment using the shortest augmenting path method
+    // of Jonker and Volgenant. Faster than Munkres on all but tiny problems.
+    // --------------------------------------------------------------------------
+    template <typename T>
+    void assignmentjv(int *assignment, T *cost, const T *distMatrixIn, size_t rowStride, size_t colStride, int nOfRows, int nOfColumns, AssignmentWorkspace<T>& workspace);
+    // --------------------------------------------------------------------------
+    // Computes a near optimal assignment with Bertsekas' auction algorithm, with
+    // epsilon scaling, where the rows still looking for a column bid in parallel.
+    // --------------------------------------------------------------------------
+    template <typename T>
+    void assignmentauction(int *assignment, T *cost, const T *distMatrixIn, size_t rowStride, size_t colStride, int nOfRows, int nOfColumns, AssignmentWorkspace<T>& workspace);
+    // --------------------------------------------------------------------------
+    // The row-major n x m costs, n <= m, of the problem or its transpose.
+    // --------------------------------------------------------------------------
+    template <typename T>
+    const T *rowmajorcosts(const T *distMatrixIn, size_t rowStride, size_t colStride, int nOfRows, int nOfColumns, size_t *stride, AssignmentWorkspace<T>& workspace);
+    // --------------------------------------------------------------------------
+    // Assigns the free rows of a Jonker-Volgenant problem by shortest augmenting
+    // paths. Returns the number of rows augmented.
+    // --------------------------------------------------------------------------
+    template <typename T>
+    int augmentjv(const T *c, size_t stride, int n, int m, T *v, int *rowSolution, int *colSolution, AssignmentWorkspace<T>& workspace);
 public:
-    enum TMethod { optimal, many_forbidden_assignments, without_forbidden_assignments };
+    enum TMethod { optimal, many_forbidden_assignments, without_forbidden_assignments, jonker_volgenant, auction };
     AssignmentProblemSolver();
     ~AssignmentProblemSolver();
     double Solve(vector<vector<double> >& DistMatrix,vector<int>& Assignment,TMethod Method=optimal);
+    // --------------------------------------------------------------------------
+    // Same as above, but only solves the top-left nOfRows x nOfColumns block of
+    // DistMatrix, so callers can keep one matrix sized for their largest problem.
+    // --------------------------------------------------------------------------
+    double Solve(const vector<vector<double> >& DistMatrix,int nOfRows,int nOfColumns,vector<int>& Assignment,TMethod Method=optimal);
+    // --------------------------------------------------------------------------
+    // Solves the nOfRows x nOfColumns problem stored row-major in Costs, where
+    // row i starts at Costs + i*RowStride (so this also takes a block of a bigger
+    // matrix, or a cv::Mat_<float> through ptr() and step1()). The costs are read
+    // in place: Munkres makes the one working copy it reduces, and Jonker-
+    // Volgenant copies nothing unless there are more rows than columns. All the
+    // scratch memory comes from Workspace and nothing else in the solver is
+    // touched, so threads may share a solver as long as each has its own
+    // workspace. T is float or double; float halves the memory the costs take.
+    // --------------------------------------------------------------------------
+    template <typename T>
+    T Solve(const T *Costs,int nOfRows,int nOfColumns,size_t RowStride,vector<int>& Assignment,AssignmentWorkspace<T>& Workspace,TMethod Method=optimal);
+    // --------------------------------------------------------------------------
+    // The number of bytes held by the solver's buffers.
+    // --------------------------------------------------------------------------
+    size_t reservedBytes() const;
+    // --------------------------------------------------------------------------
+    // The auction method stops once every row's column is within Tolerance of
+    // the best column for it at the final prices, so the total cost is at most
+    // max(nOfRows, nOfColumns) * Tolerance above the optimum. A larger tolerance
+    // takes fewer rounds of bidding. The default is 1e-6. (It is raised to what
+    // the cost type can resolve, so float costs may not reach tiny tolerances.)
+    // --------------------------------------------------------------------------
+    void SetAuctionTolerance(double Tolerance);
+    // --------------------------------------------------------------------------
+    // Solves the square N x N problem in the row-major Costs with the Jonker-
+    // Volgenant solver, starting from the given column prices and assignment of
+    // rows to columns (-1 for a free row) instead of from scratch. A row keeps its
+    // starting column only if that column has the smallest cost minus price in the
+    // row (and no earlier row kept it), so any start gives an optimal assignment,
+    // and a close one (last frame's prices) leaves only a few rows to augment.
+    // ColumnPrices and Assignment are updated in place, ready to start the next
+    // problem from. Like Solve with a workspace, all the scratch memory comes
+    // from Workspace. Returns the number of rows that had to be augmented.
+    // --------------------------------------------------------------------------
+    int SolveWarm(const double *Costs, int N, vector<double>& ColumnPrices, vector<int>& Assignment, AssignmentWorkspace<double>& Workspace);
+private:
+    // --------------------------------------------------------------------------
+    // The solvers read element (row, col) of the costs at
+    // distMatrixIn[row*rowStride + col*colStride], so they take row-major and
+    // column-major layouts alike.
+    // --------------------------------------------------------------------------
+    template <typename T>
+    T solve(const T *distMatrixIn, size_t rowStride, size_t colStride, int nOfRows, int nOfColumns, vector<int>& Assignment, AssignmentWorkspace<T>& workspace, TMethod Method);
 };
 
 #endif /* hungarian_h */
@@ -0,0 +1,34 @@
+#ifndef benchmark_mode_h
+#define benchmark_mode_h
+
+#include "lib/cmdparser.hpp"
+
+/**
+ * Runs one of the benchmarks (chosen with -b) and prints the results to the console.
+ * Nothing is shown on the screen.
+ *
+ * luma - Run detection on the input video twice, once on BGR frames and once on grayscale
+ *        frames, and compare the frame rate and the number of objects found.
+ * tracking - Find the objects in the input video, then time only the tracker's updates, and
+ *            fail if a steady-state frame allocates.
+ * assignment - Time the assignment solvers on synthetic problems and check that they find
+ *              assignments of the same cost. The input video is ignored.
+ * association - Time the tracker with each association, with and without the cascade, on
+ *               synthetic crowded scenes. The input video is ignored.
+ * partitioned - Time a single tracker and trackers split into zones on wide synthetic scenes,
+ *               and compare how many objects they report, the IDs they give out, and how often
+ *               the objects' IDs change. The input video is ignored.
+ * parallel - Time the tracker with serial and parallel per-tracker updates on wide synthetic
+ *            scenes, and check that their outputs are identical. The input video is ignored.
+ */
+namespace OT {
+    namespace Mode {
+        namespace Benchmark {
+            // Returns the exit status, which is non-zero if the benchmark failed a check.
+            int run(const cli::Parser& parser);
+        }
+    }
+}
+
+
+#endif /* benchmark_mode_h */
@@ -0,0 +1,20 @@
+#ifndef pipelined_tracking_mode_h
+#define pipelined_tracking_mode_h
+
+#include "lib/cmdparser.hpp"
+
+/**
+ * Same as the tracking mode, but decoding, preprocessing (perspective transform and scaling),
+ * detection (background subtraction and contours), and tracking each run on their own thread,
+ * connected by bounded queues. Per-stage queue depths and stall times are printed at the end.
+ */
+namespace OT {
+    namespace Mode {
+        namespace PipelinedTracking {
+            void run(const cli::Parser& parser);
+        }
+    }
+}
+
+
+#endif /* pipelined_tracking_mode_h */
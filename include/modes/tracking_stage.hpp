@@ -0,0 +1,84 @@
+#ifndef tracking_stage_h
+#define tracking_stage_h
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "lib/cmdparser.hpp"
+#include "tracker/multi_object_tracker.hpp"
+#include "tracker/partitioned_tracker.hpp"
+#include "tracker/tracker_log.hpp"
+#include "utils/frame_transformer.hpp"
+
+namespace OT {
+    namespace Mode {
+        /**
+         * Open the webcam given by -w, or otherwise the video given by -i, and complain if it
+         * can't be opened. Shared by the tracking and pipelined tracking modes.
+         */
+        void openVideoSource(const cli::Parser& parser, cv::VideoCapture& capture);
+        
+        /**
+         * The per-frame work that the tracking and pipelined tracking modes share once the objects
+         * in a frame have been found: moving the detections into tracking coordinates, updating the
+         * tracker (created on the first frame, configured from the command line, and split into
+         * zones if there's a zone grid), drawing the
+         * predictions, and logging them to the support file given by -s.
+         */
+        class TrackingStage {
+        private:
+            // The options the tracker is created with.
+            const cli::Parser& parser;
+            
+            // Maps the detections into the space the objects are tracked in.
+            OT::FrameTransformer& frameTransformer;
+            
+            // In headless mode, nothing is drawn.
+            bool headless;
+            
+            // This does the actual tracking of the objects. It's created on the first frame,
+            // because it needs to know the size of the frame. With a zone grid (-zg) bigger than
+            // one zone, partitionedTracker does the tracking instead.
+            std::unique_ptr<OT::MultiObjectTracker> tracker;
+            std::unique_ptr<OT::PartitionedTracker> partitionedTracker;
+            
+            // Create the tracker for the given tracking space, configured from the command line.
+            void createTracker(cv::Size trackingSize);
+            
+            // The tracker's output for the current frame, reused so that it keeps its capacity.
+            std::vector<OT::TrackingOutput> predictions;
+            
+            // This will log all of the tracked objects, if there's a file to log them to.
+            OT::TrackerLog trackerLog;
+            std::string outputFilePath;
+            std::ofstream outputFile;
+        public:
+            TrackingStage(const cli::Parser& parser, OT::FrameTransformer& frameTransformer);
+            
+            /**
+             * Track the objects found in frame (the transformed frame that the contours were found in).
+             * Unless we're headless, the contours are shown and display is set to the frame in tracking
+             * coordinates with the predictions drawn on it. The mass centers and bounding boxes are moved
+             * into tracking coordinates in place.
+             */
+            void track(long frameNumber,
+                       const cv::Mat& frame,
+                       const std::vector<std::vector<cv::Point>>& contours,
+                       std::vector<cv::Point2f>& massCenters,
+                       std::vector<cv::Rect>& boundingBoxes,
+                       cv::Mat& display);
+            
+            /**
+             * Write the log of every tracked object to the support file, if there is one.
+             */
+            void finish();
+        };
+    }
+}
+
+
+#endif /* tracking_stage_h */
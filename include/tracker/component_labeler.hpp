@@ -0,0 +1,115 @@
+#ifndef component_labeler_h
+#define component_labeler_h
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+namespace OT {
+    /**
+     * Statistics for a blob of foreground pixels. Two blobs can be combined without
+     * looking at their pixels again.
+     */
+    struct BlobStats {
+        // The number of pixels in the blob.
+        double area;
+        
+        // The sums of the x and y coordinates of the pixels in the blob.
+        double sumX;
+        double sumY;
+        
+        // The extent of the blob (inclusive).
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+        
+        // A blob with no pixels.
+        BlobStats();
+        
+        // Add the pixels [startX, endX) of row y to the blob.
+        void addRun(int y, int startX, int endX);
+        
+        // Add all the pixels of the other blob to this one.
+        void merge(const BlobStats& other);
+        
+        // The center of mass.
+        cv::Point2f massCenter() const;
+        
+        // The bounding box around the pixels.
+        cv::Rect boundingBox() const;
+    };
+    
+    /**
+     * Finds the 8-connected components of a binary image and their statistics in a single
+     * pass, without building a label image. The image is split into horizontal strips which
+     * are labeled in parallel, and components that cross strip boundaries are joined afterwards.
+     */
+    class ComponentLabeler {
+    private:
+        friend class StripLabelingBody;
+        
+        // A horizontal run of foreground pixels [start, end) with a provisional label.
+        struct Run {
+            int start;
+            int end;
+            int label;
+        };
+        
+        // The labeling state for one horizontal strip of the image.
+        struct Strip {
+            int startRow;
+            int endRow;
+            
+            // Union-find over the provisional labels in this strip.
+            std::vector<int> parent;
+            
+            // The statistics accumulated for each provisional label.
+            std::vector<OT::BlobStats> stats;
+            
+            // The runs in the first and last row of the strip, used to join strips.
+            std::vector<Run> firstRow;
+            std::vector<Run> lastRow;
+            
+            // The runs in the previous and current row while labeling.
+            std::vector<Run> previous;
+            std::vector<Run> current;
+        };
+        
+        // Label the pixels in one strip.
+        static void labelStrip(const cv::Mat& binary, Strip& strip);
+        
+        // Find the root label, halving the path along the way.
+        static int find(std::vector<int>& parent, int label);
+        
+        // Join the sets of the two labels.
+        static void join(std::vector<int>& parent, int a, int b);
+        
+        // Join the labels of runs that touch across two adjacent rows.
+        static void joinRows(std::vector<int>& parent,
+                             const std::vector<Run>& above, int aboveOffset,
+                             const std::vector<Run>& below, int belowOffset);
+        
+        // Strips are at least this tall.
+        int minStripHeight;
+        
+        // Kept between calls so the buffers can be reused.
+        std::vector<Strip> strips;
+        std::vector<int> parent;
+        std::vector<int> blobForLabel;
+        std::vector<int> offsets;
+    public:
+        ComponentLabeler(int minStripHeight = 32);
+        
+        /**
+         * Find the connected components of the non-zero pixels in the single channel 8-bit image,
+         * and put their statistics in blobs (in no particular order).
+         */
+        void label(const cv::Mat& binary, std::vector<OT::BlobStats>& blobs);
+        
+        // The number of bytes reserved by the buffers that are kept between calls.
+        size_t reservedBytes() const;
+    };
+}
+
+#endif /* component_labeler_h */
@@ -6,11 +6,52 @@
 #include <opencv2/opencv.hpp>
 #include <opencv2/video/tracking.hpp>
 
+#include "tracker/component_labeler.hpp"
+#include "lib/disjoint_set.hpp"
+
 namespace OT {
+    /**
+     * The buffers that ContourFinder uses while processing a frame. They keep their capacity
+     * between frames, so once they've grown to fit the scene, they don't need to be reallocated.
+     */
+    struct ContourFinderWorkspace {
+        // The median filtered foreground, before it's dilated back into the foreground.
+        cv::Mat filtered;
+        
+        // The statistics of the blobs (or of the contours) found in the current frame.
+        std::vector<OT::BlobStats> blobs;
+        std::vector<cv::Rect> blobBoxes;
+        
+        // The polygon approximating the contour whose bounding box we're finding.
+        std::vector<cv::Point> contourPolygon;
+        
+        // The uniform grid used to find nearby bounding boxes. Boxes in cell c are
+        // cellEntries[cellStart[c]] through cellEntries[cellStart[c + 1] - 1].
+        std::vector<int> cellStart;
+        std::vector<int> cellEntries;
+        std::vector<int> cellFill;
+        std::vector<int> lastVisitedBy;
+        
+        // The pairs (i < j) of bounding boxes that are close enough to merge.
+        std::vector<std::pair<int, int>> mergePairs;
+        
+        // The sets of contours (or blobs) that get merged, and the index of each one's set.
+        DisjointSets mergeSets;
+        std::vector<int> mergeSetIds;
+        
+        // The number of bytes reserved by all the buffers.
+        size_t reservedBytes() const;
+    };
+    
     /**
      * This class will find blobs representing objects in a frame. It uses
      * background subtraction to isolate the foreground, does some preprocessing, finds
      * contours, and removes small contours.
+     *
+     * Nearby contours are merged by combining their statistics (area, mass center, bounding
+     * box), so their points are never copied. Instead of contours, it can also find blobs with
+     * connected component labeling. Then only the statistics of each blob are computed and the
+     * contours are never built.
      */
     class ContourFinder {
     private:
@@ -20,7 +61,7 @@ namespace OT {
         // The foreground of the frame that should contain the blobs.
         cv::Mat foreground;
         
-        // Remove contours that are too small.
+        // Remove contours that are too small. Uses the areas in blobs.
         void filterOutBadContours(std::vector<std::vector<cv::Point>>& contours);
         
         // Filter out contours whose area is <= contourSizeThreshold * area of largest contour.
@@ -37,27 +78,86 @@ namespace OT {
         // The length of the diagonal.
         float diagonal;
         
+        // Whether to skip showing the foreground window.
+        bool headless;
+        
+        // Whether to find blobs with connected component labeling instead of contours.
+        bool connectedComponents;
+        
+        // Finds the blobs when we're using connected component labeling.
+        OT::ComponentLabeler labeler;
+        
+        // The buffers used while processing a frame, kept between frames.
+        ContourFinderWorkspace workspace;
+        
+        // The bytes reserved by the workspace after the last frame, and the number of
+        // frames (after the first) that made it grow.
+        size_t workspaceBytes;
+        long numBufferGrowths;
+        
+        /**
+         * Union the pairs in mergePairs and fill mergeSetIds with the merged set of each of
+         * the numItems items. Sets are numbered in order of their first item. Returns the
+         * number of sets.
+         */
+        int findMergeSets(int numItems);
+        
+        /**
+         * Fill mergePairs with every pair of bounding boxes that are closer than
+         * contourMergeThreshold * diagonal, ordered by i and then j. Only boxes in
+         * nearby grid cells are compared.
+         */
+        void findMergePairs(const std::vector<cv::Rect>& boundingBoxes);
+        
         // Ignore mass centers that appear in these rectangles.
         std::vector<cv::Rect> suppressRectangles;
         
-        // Suppress any mass centers that appear in the suppress rectangles.
-        void suppressMassCenters(std::vector<std::vector<cv::Point>>& contours,
-                                 std::vector<cv::Point2f>& massCenters,
-                                 std::vector<cv::Rect>& boundingBoxes);
+        // Whether the mass center of the blob appears in one of the suppress rectangles.
+        bool isSuppressed(const OT::BlobStats& blob) const;
+        
+        // Suppress any contours whose mass centers appear in the suppress rectangles.
+        void suppressMassCenters(std::vector<std::vector<cv::Point>>& contours);
         
         /**
-         * Find the mass centers and bounding boxes for the given contours.
+         * Remove the contours, along with their statistics in blobs, for which
+         * shouldRemove(statistics) is true.
          */
-        void getCentersAndBoundingBoxes(const std::vector<std::vector<cv::Point>>& contours,
-                                        std::vector<cv::Point2f>& massCenters,
-                                        std::vector<cv::Rect>& boundingBoxes);
+        template <typename Predicate>
+        void removeContours(std::vector<std::vector<cv::Point>>& contours, Predicate shouldRemove);
+        
+        /**
+         * Find the area, mass center, and bounding box of each contour.
+         */
+        void getContourStats(const std::vector<std::vector<cv::Point>>& contours,
+                             std::vector<OT::BlobStats>& blobs);
         
         /**
-         * Merge nearby contours.
+         * Find the contours in the foreground, and the mass centers and bounding boxes of
+         * the (merged) objects they represent.
          */
-        void mergeContours(std::vector<std::vector<cv::Point> > &contours,
-                           const std::vector<cv::Point2f>& massCenters,
-                           const std::vector<cv::Rect>& boundingBoxes);
+        void findContourBlobs(std::vector<cv::Vec4i>& hierarchy,
+                              std::vector<std::vector<cv::Point>>& contours,
+                              std::vector<cv::Point2f>& massCenters,
+                              std::vector<cv::Rect>& boundingBoxes);
+        
+        /**
+         * Find the mass centers and bounding boxes of the blobs in the foreground using
+         * connected component labeling.
+         */
+        void findBlobs(std::vector<cv::Point2f>& massCenters,
+                       std::vector<cv::Rect>& boundingBoxes);
+        
+        // The blob equivalents of the contour functions above.
+        void filterOutBadBlobs(std::vector<OT::BlobStats>& blobs);
+        void suppressBlobs(std::vector<OT::BlobStats>& blobs);
+        
+        // Merge nearby blobs (or contours) by combining their statistics.
+        void mergeBlobs(std::vector<OT::BlobStats>& blobs);
+        
+        // Find the mass centers and bounding boxes of the (merged) blobs.
+        void getCentersAndBoundingBoxes(const std::vector<OT::BlobStats>& blobs,
+                                        std::vector<cv::Point2f>& massCenters,
+                                        std::vector<cv::Rect>& boundingBoxes);
     public:
         ContourFinder(int history = 1000,
                       int nMixtures = 3,
@@ -66,7 +166,9 @@ namespace OT {
                       float contourMergeThreshold = 0.01);
         
         /**
-         * Find contours representing the objects in the frame.
+         * Find contours representing the objects in the frame. There is one mass center and
+         * bounding box per object, where an object may be made of several nearby contours. When
+         * using connected component labeling, the contours are left empty.
          */
         void findContours(const cv::Mat& frame,
                           std::vector<cv::Vec4i>& hierarchy,
@@ -75,6 +177,23 @@ namespace OT {
                           std::vector<cv::Rect>& boundingBoxes);
         
         void suppressRectangle(cv::Rect rect);
+        
+        /**
+         * Don't create any windows (i.e. the "foreground" window) while finding contours.
+         */
+        void setHeadless(bool headless);
+        
+        /**
+         * Find blobs with connected component labeling instead of contours.
+         */
+        void setConnectedComponents(bool connectedComponents);
+        
+        /**
+         * The number of frames, not counting the first, during which the workspace or labeler
+         * buffers had to grow. This only watches those buffers: the OpenCV functions, the
+         * contours found by cv::findContours, and the output vectors can still allocate.
+         */
+        long bufferGrowths() const;
     };
 }
 
@@ -0,0 +1,109 @@
+#ifndef gated_assigner_h
+#define gated_assigner_h
+
+#include <vector>
+#include <memory>
+
+#include "lib/hungarian.hpp"
+#include "lib/disjoint_set.hpp"
+
+namespace OT {
+    /**
+     * Assigns rows (trackers) to columns (mass centers) when only some pairs are allowed.
+     * The allowed pairs form a bipartite graph which usually falls apart into many small
+     * connected components (groups of nearby objects), and each component is solved on its
+     * own with a small dense matrix. When there are many components, they are solved in
+     * parallel.
+     *
+     * Within a component, pairs that aren't allowed are given a cost larger than the sum of
+     * all the allowed costs, so the solver first makes as many allowed assignments as it can
+     * and then picks the cheapest of those. Rows that end up with a pair that isn't allowed
+     * are left unassigned.
+     */
+    class GatedAssigner {
+    private:
+        friend class ComponentSolvingBody;
+        
+        // An allowed pair.
+        struct Pair {
+            int row;
+            int column;
+            double cost;
+        };
+        
+        // A group of components solved one after another on the same thread, with the
+        // row-major dense problem of the current component and the solver's scratch memory.
+        struct Stripe {
+            std::vector<double> costs;
+            std::vector<int> assignment;
+            AssignmentWorkspace<double> workspace;
+        };
+        
+        // The method used for each component. The solver is shared by the stripes, which
+        // each bring their own workspace.
+        AssignmentProblemSolver::TMethod method;
+        AssignmentProblemSolver solver;
+        
+        // Solve in parallel when there are at least this many components that aren't a single pair.
+        int minParallelComponents;
+        
+        int numRows;
+        int numColumns;
+        std::vector<Pair> pairs;
+        
+        // Rows are elements [0, numRows) and columns are [numRows, numRows + numColumns).
+        DisjointSets components;
+        std::vector<int> componentIds;
+        
+        // The rows, columns, and pairs of component c are in [rowStart[c], rowStart[c + 1]),
+        // and so on, of componentRows, componentColumns, and componentPairs.
+        std::vector<int> rowStart;
+        std::vector<int> columnStart;
+        std::vector<int> pairStart;
+        std::vector<int> componentRows;
+        std::vector<int> componentColumns;
+        std::vector<int> componentPairs;
+        
+        // The index of each row and column within its component.
+        std::vector<int> localIndex;
+        
+        // The next free slot of each component while grouping.
+        std::vector<int> cursor;
+        
+        // The components that need a solver (more than one row or column).
+        std::vector<int> largeComponents;
+        
+        // The stripes are kept behind pointers so the ones in use never move while growing.
+        std::vector<std::unique_ptr<Stripe>> stripes;
+        
+        // The column assigned to each row.
+        std::vector<int> rowAssignment;
+        
+        // Group the rows, columns, and pairs by component.
+        int groupByComponent();
+        
+        // Solve component c and store its assignment in rowAssignment.
+        void solveComponent(int c, Stripe& stripe);
+    public:
+        GatedAssigner(AssignmentProblemSolver::TMethod method = AssignmentProblemSolver::optimal,
+                      int minParallelComponents = 64);
+        
+        // Start a new problem with the given number of rows and columns and no allowed pairs.
+        void reset(int numRows, int numColumns);
+        
+        // Allow the row to be assigned to the column at the given (non-negative) cost.
+        void allow(int row, int column, double cost);
+        
+        /**
+         * Solve the problem. Afterwards, assignment[row] is the column assigned to each row,
+         * or -1 if the row wasn't assigned. Returns the number of components with at least
+         * one pair.
+         */
+        int solve(std::vector<int>& assignment);
+        
+        // The number of bytes reserved by all the buffers.
+        size_t reservedBytes() const;
+    };
+}
+
+#endif /* gated_assigner_h */
@@ -1,17 +1,44 @@
 #ifndef multi_object_tracker_h
 #define multi_object_tracker_h
 
+#include <string>
 #include <vector>
 
 #include <opencv2/opencv.hpp>
 
-#include "kalman_tracker.hpp"
+#include "tracker/tracking_output.hpp"
+#include "tracker/tracker_bank.hpp"
+#include "tracker/gated_assigner.hpp"
+#include "tracker/point_grid.hpp"
+#include "lib/hungarian.hpp"
 
 namespace OT {
     class MultiObjectTracker {
+    public:
+        // How trackers are associated with mass centers each frame.
+        enum Association {
+            // Solve one problem over every pair of tracker and mass center, then drop the
+            // pairs that are too far apart.
+            dense,
+            
+            // Only consider the pairs that are close enough, and solve each group of nearby
+            // trackers and mass centers separately (in parallel if there are many). This
+            // maximizes the number of close pairs before minimizing their distances, so the
+            // assignments can differ from dense.
+            gated,
+            
+            // Solve the same problem as dense, but start from the last frame's solution, so
+            // only the trackers whose situation changed need to be reassigned.
+            incremental,
+            
+            // Solve the same problem as dense with an auction, in which the trackers bid for
+            // mass centers in parallel. The total distance may be a little more than dense's
+            // (see auctionTolerance), in exchange for less time in crowded scenes.
+            auction
+        };
     private:
         // The actual object trackers.
-        std::vector<OT::KalmanTracker> kalmanTrackers;
+        OT::TrackerBank kalmanTrackers;
         
         // We only care about trackers who have been alive for the
         // given lifetimeThreshold number of frames.
@@ -36,6 +63,8 @@ namespace OT {
         float magnitudeOfAccelerationNoise;
         
         // Check if the Kalman filter at index i has another Kalman filter that can suppress it.
+        // Filters already marked in shouldRemove can't suppress anything. Only the filters near
+        // it in trackerGrid are looked at.
         bool hasSuppressor(size_t i);
         
         // Any Kalman filter with a lifetime above this value cannot be suppressed.
@@ -48,9 +77,145 @@ namespace OT {
         // A Kalman filter can only be suppressed by another filter which is threshold times its age.
         float ageSuppressionThreshold;
         
-        // Check if the tracker prediction at index i shares the given
-        // bounding rectangle with another point.
-        bool sharesBoundingRect(size_t i, cv::Rect boundingRect);
+        // Find the trackers whose latest prediction is in each bounding rectangle, and the
+        // number of rectangles each tracker is in.
+        void findContainingRects(const std::vector<cv::Rect>& boundingRects);
+        
+        // Mark each tracker whose latest prediction is in one of the bounding rectangles along
+        // with another tracker's as updated.
+        void markSharedBoundingRects();
+        
+        // Rebuild trackerGrid from the latest predictions of the trackers.
+        void indexTrackers();
+        
+        Association association;
+        
+        // Whether to match the unambiguous pairs before the association.
+        bool cascade;
+        
+        /**
+         * Match each mass center whose bounding rectangle holds trackers that aren't in any
+         * other rectangle to the oldest of them (if no other is as old and it's within
+         * distanceThreshold). The rest of the trackers and mass centers are gathered for
+         * the association: predictions, solverTrackers, solverCenters, and
+         * solverMassCenters only hold the ones that are left.
+         */
+        void matchContained(const std::vector<cv::Point2f>& massCenters);
+        
+        // Associate the trackers in predictions with the mass centers.
+        void associate(const std::vector<cv::Point2f>& massCenters);
+        
+        // The length of the frame diagonal, which distances are divided by.
+        double frameDiagonal;
+        
+        // The suppression distance in pixels, rounded up, which is also the cell size of trackerGrid.
+        int suppressionReach;
+        
+        /**
+         * Fill assignment with the mass center assigned to each tracker (from predictions) by
+         * solving one dense problem over all the pairs, and dropping the assignments that are
+         * further apart than distanceThreshold.
+         */
+        void assignDense(const std::vector<cv::Point2f>& massCenters,
+                         AssignmentProblemSolver::TMethod method = AssignmentProblemSolver::optimal);
+        
+        /**
+         * Same as assignDense, but only pairs within distanceThreshold are considered, and the
+         * groups of trackers and mass centers that can't be paired with each other are solved
+         * as separate problems. Every tracker that isn't assigned is marked as not updated.
+         */
+        void assignGated(const std::vector<cv::Point2f>& massCenters);
+        
+        /**
+         * Same as assignDense, but the problem is padded to a square and solved with the
+         * Jonker-Volgenant solver starting from last frame's solution. Each tracker starts
+         * out on the mass center closest to it (or on a padding column if it got nothing
+         * last frame), at the price its match had last frame.
+         */
+        void assignIncremental(const std::vector<cv::Point2f>& massCenters);
+        
+        /**
+         * Fill the first numRows rows of costMatrix, each stride long, with the normalized
+         * distances between predictions and massCenters. Whatever is past the trackers and
+         * mass centers is zero.
+         */
+        void fillCostMatrix(const std::vector<cv::Point2f>& massCenters, size_t numRows, size_t stride);
+        
+        // Unassign the trackers that are too far from their mass centers, and mark the ones
+        // without one as not updated.
+        void dropDistantAssignments();
+        
+        // Mark the trackers without a mass center as not updated.
+        void markUnassigned();
+        
+        // The buffers below are only used inside update. They're kept between frames so that
+        // once they fit the scene, update doesn't allocate.
+        
+        // The normalized distance between each tracker (row) and mass center (column), stored
+        // row-major with costStride elements per row so the solver can read it in place.
+        std::vector<double> costMatrix;
+        size_t costStride;
+        
+        // The mass center assigned to each tracker (or -1).
+        std::vector<int> assignment;
+        
+        // The latest prediction of each tracker the association solves for.
+        std::vector<cv::Point2f> predictions;
+        
+        // Flags for each tracker, and whether each mass center was assigned a tracker.
+        std::vector<unsigned char> shouldPredict;
+        std::vector<unsigned char> shouldRemove;
+        std::vector<unsigned char> centerIsAssigned;
+        
+        // The latest predictions of the trackers, indexed by position.
+        std::vector<cv::Point> trackerPositions;
+        OT::PointGrid trackerGrid;
+        
+        // The trackers in bounding rectangle r are rectTrackers[rectStart[r], rectStart[r + 1]),
+        // and each tracker is in trackerRectCount rectangles.
+        std::vector<int> rectStart;
+        std::vector<int> rectTrackers;
+        std::vector<int> trackerRectCount;
+        std::vector<unsigned char> sharesRect;
+        
+        // The tracker of each row and the mass center of each column the association solves
+        // for, and the positions of those mass centers.
+        std::vector<int> solverTrackers;
+        std::vector<int> solverCenters;
+        std::vector<cv::Point2f> solverMassCenters;
+        
+        // The mass center each tracker was matched to by the cascade (or -1), and whether each
+        // mass center was.
+        std::vector<int> cascadeAssignment;
+        std::vector<unsigned char> cascadeMatched;
+        
+        AssignmentProblemSolver solver;
+        AssignmentWorkspace<double> workspace;
+        OT::GatedAssigner gatedAssigner;
+        
+        // The column prices and assignment of the padded square problem of the incremental
+        // association. startedColumns flags the columns some tracker starts out on, and
+        // startingSlack is the cost minus price of each tracker's starting column.
+        std::vector<double> columnPrices;
+        std::vector<int> squareAssignment;
+        std::vector<unsigned char> startedColumns;
+        std::vector<double> startingSlack;
+        
+        // The total time spent associating trackers with mass centers, and the number of
+        // trackers the incremental association had to augment.
+        double associationSeconds;
+        long numAugmentedRows;
+        
+        // The bytes reserved by the buffers after the last frame, and the number of frames
+        // (after the first) that made them grow.
+        size_t scratchBytes;
+        long numScratchGrowths;
+        
+        // The number of bytes reserved by the tracker, its solver, and its buffers.
+        size_t reservedBytes() const;
+        
+        // Count the frame as a growth if reservedBytes went up.
+        void recordScratchGrowth();
     public:
         MultiObjectTracker(cv::Size frameSize,
                            long lifetimeThreshold = 20,
@@ -60,12 +225,87 @@ namespace OT {
                            float magnitudeOfAccelerationNoise = 0.5,
                            int lifetimeSuppressionThreshold = 20,
                            float distanceSuppressionThreshold = 0.1,
-                           float ageSuppressionThreshold = 2);
+                           float ageSuppressionThreshold = 2,
+                           Association association = dense,
+                           double auctionTolerance = 1e-4);
         
         // Update the object tracker with the mass centers of the observed boundings rects.
         void update(const std::vector<cv::Point2f>& massCenters,
                     const std::vector<cv::Rect>& boundingRects,
                     std::vector<OT::TrackingOutput>& trackingOutputs);
+        
+        /**
+         * Same as update, but only the first numStarting mass centers can start new trackers.
+         * The rest can only update the trackers that already follow them.
+         */
+        void update(const std::vector<cv::Point2f>& massCenters,
+                    const std::vector<cv::Rect>& boundingRects,
+                    size_t numStarting,
+                    std::vector<OT::TrackingOutput>& trackingOutputs);
+        
+        /**
+         * The number of frames (after the first) during which the tracker had to grow its
+         * trackers or scratch buffers. Once the number of trackers and mass centers stops
+         * reaching new highs, this stops increasing, and update doesn't allocate (other than
+         * in trackingOutputs, if the caller doesn't reuse it).
+         */
+        long scratchGrowths() const;
+        
+        // How to associate trackers with mass centers (dense by default).
+        void setAssociation(Association association);
+        
+        // Set the association by name (dense, gated, incremental, or auction). Returns false if there is no such association.
+        bool setAssociation(const std::string& name);
+        
+        /**
+         * Whether to match the trackers that are alone in a bounding rectangle (or clearly the
+         * oldest in it) to its mass center before the association, which then only solves for
+         * the rest (off by default). This can pick different pairs than the association would.
+         */
+        void setCascade(bool cascade);
+        
+        /**
+         * Predict, correct, and output the trackers in parallel ranges once there are at least
+         * minParallelTrackers of them (0, the default, keeps them serial). The association is
+         * unchanged and each tracker is updated the same way, so the outputs are identical.
+         */
+        void setMinParallelTrackers(size_t minParallelTrackers);
+        
+        /**
+         * Move the tracker with the given ID to another MultiObjectTracker (with the same
+         * configuration), which gives it a new ID. The destination drops the trackers it hasn't
+         * reported yet that the arriving one would suppress, since a single tracker wouldn't
+         * have started them. Returns the new ID, or -1 if there's no tracker with the ID. Like
+         * update, this invalidates the trajectories of the outputs.
+         */
+        int handOver(int id, MultiObjectTracker& destination);
+        
+        /**
+         * Fill outputs with every tracker, including the ones too young to be reported. Like
+         * update's outputs, their trajectories are only valid until the next update.
+         */
+        void allTrackingOutputs(std::vector<OT::TrackingOutput>& outputs);
+        
+        /**
+         * Remove the trackers that haven't been reported yet and that a tracker with the given
+         * lifetime at the given position would suppress. Trackers that each cover part of a frame
+         * use this to suppress each other's young trackers near their borders, like a single
+         * tracker would. Like update, this invalidates the trajectories of the outputs.
+         */
+        void suppressUnreported(const cv::Point& position, long lifetime);
+        
+        // The furthest (in pixels) a tracker can be from a younger one to suppress it.
+        double suppressionDistance() const;
+        
+        // The furthest (in pixels) a mass center can be from a tracker's prediction for them to be matched.
+        double associationGate() const;
+        
+        // The total time spent associating trackers with mass centers.
+        double associationTime() const;
+        
+        // The total number of trackers that incremental association couldn't keep on their
+        // starting mass center and had to reassign with an augmenting path.
+        long augmentedRows() const;
     };
 }
 
@@ -0,0 +1,185 @@
+#ifndef partitioned_tracker_h
+#define partitioned_tracker_h
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "tracker/tracking_output.hpp"
+#include "tracker/multi_object_tracker.hpp"
+
+namespace OT {
+    /**
+     * Tracks objects in a wide frame by splitting it into a grid of zones, each with its own
+     * MultiObjectTracker, and updating the zones in parallel. The cost of associating trackers
+     * with mass centers then depends on how many objects are in a zone, not in the whole frame.
+     *
+     * Each zone is given the mass centers in its core (its cell of the grid) and in a band of
+     * overlap pixels around it, so the zones on both sides of a border see the objects near it.
+     * Only the mass centers in a zone's core can start trackers in it, so an object near a border
+     * is usually only followed by the zone it started in, and any tracker that crosses into
+     * another zone's core moves there at the start of the next update.
+     *
+     * Every zone tracker has its own IDs, which are mapped to global IDs, and each global ID
+     * belongs to one zone at a time, which reports it. When a track crosses into the core of
+     * another zone, it's handed off: if that zone has its own track close to it (wherever that
+     * track is, since it may not have crossed yet), the global ID moves to that track, and
+     * otherwise the tracker itself moves to that zone at the start of the next update. Either
+     * way the object keeps its ID (and a moved tracker keeps its age, so the new zone
+     * suppresses its own young trackers for it like a single tracker would). A track that
+     * handed its ID over keeps it without reporting it, and takes it back if the object crosses
+     * back or the track it went to is removed. A track in a zone's core gets a new global ID
+     * unless it's within overlap of a track in another zone that's within its band, which it's
+     * left to take over from.
+     *
+     * The zone trackers use the whole frame size, so their distance thresholds are the same as
+     * a single MultiObjectTracker's.
+     */
+    class PartitionedTracker {
+    private:
+        friend class ZoneUpdatingBody;
+        
+        // A zone tracker's ID for a track and its global ID, which it reports unless it handed
+        // it over to another zone's track following the same object.
+        struct Link {
+            int localId;
+            int globalId;
+            bool isReporting;
+        };
+        
+        // A tracker in another zone's core, which can suppress a zone's younger trackers near it.
+        struct Suppressor {
+            cv::Point location;
+            long lifetime;
+        };
+        
+        // A zone of the frame, with its tracker, its mass centers and bounding rectangles for
+        // this frame (the first numCoreCenters of which are in its core), the tracker's outputs
+        // and all of its trackers (reported or not), and the other zones' trackers that suppress
+        // its young trackers before the next update. links is sorted by localId.
+        struct Zone {
+            OT::MultiObjectTracker tracker;
+            std::vector<cv::Point2f> massCenters;
+            std::vector<cv::Rect> boundingRects;
+            size_t numCoreCenters;
+            std::vector<OT::TrackingOutput> outputs;
+            std::vector<OT::TrackingOutput> trackers;
+            std::vector<Link> links;
+            std::vector<Suppressor> suppressors;
+            
+            Zone(cv::Size frameSize) : tracker(frameSize) {
+            }
+        };
+        
+        // A zone tracker's output, its global ID (or -1 if it doesn't have one), and whether
+        // it reports the ID.
+        struct ZoneTrack {
+            int globalId;
+            int zone;
+            int output;
+            bool isReporting;
+        };
+        
+        // A tracker to move to the zone whose core it's in.
+        struct Handoff {
+            int zone;
+            int localId;
+            int destination;
+        };
+        
+        cv::Size frameSize;
+        int numZoneColumns;
+        int numZoneRows;
+        
+        // The width of the band around each zone's core, and the furthest apart two zones'
+        // tracks can be for one to hand its ID to the other (both in pixels). That's the zone
+        // trackers' association gate, since a single tracker could match either of them to the
+        // other's mass center.
+        int overlap;
+        double handoffDistance;
+        
+        // The furthest (in pixels) a zone's tracker can be from another zone's core or band to
+        // suppress its young trackers.
+        double suppressionDistance;
+        
+        // The zones, row by row. They're kept behind pointers because they can't be copied.
+        std::vector<std::unique_ptr<Zone>> zones;
+        
+        // The next global ID to give out.
+        int nextGlobalId;
+        
+        // The zone tracks with a global ID, and the ones that don't have one (yet).
+        std::vector<ZoneTrack> tracks;
+        std::vector<ZoneTrack> unlinkedTracks;
+        
+        // The trackers to move before the next update.
+        std::vector<Handoff> handoffs;
+        
+        // Whether each global ID has a track reporting it this frame.
+        std::vector<unsigned char> isReported;
+        
+        // The column or row of the zone whose core holds x or y, clamped to the grid.
+        int zoneColumn(float x) const;
+        int zoneRow(float y) const;
+        
+        // The zone whose core holds the point.
+        int zoneIndex(const cv::Point2f& point) const;
+        
+        // Whether the point is in the zone's core or band, so the zone is given mass centers there.
+        bool isInBand(const cv::Point& point, int zone) const;
+        
+        // Give each zone the mass centers in its core, and then the ones in its band.
+        void distribute(const std::vector<cv::Point2f>& massCenters,
+                        const std::vector<cv::Rect>& boundingRects);
+        
+        // Give the zone tracks their global IDs, handing them over between zones, and find the
+        // trackers that have to move.
+        void linkTracks();
+        
+        // The zone's link for the local ID, or the end of its links if there isn't one.
+        std::vector<Link>::const_iterator findLink(const Zone& zone, int localId) const;
+        
+        // The closest of the zone's tracks within handoffDistance of the track that can take over
+        // its ID (one without an ID, or one that handed this ID over), or nullptr if there isn't one.
+        ZoneTrack* closestTwin(const ZoneTrack& track, int zone);
+        
+        // Move the trackers found by linkTracks, along with their global IDs.
+        void moveTrackers();
+        
+        // Give every zone the trackers in the other zones' cores that are close enough to
+        // suppress its young trackers. A single tracker would suppress them, but a zone only
+        // sees its own core and band.
+        void findSuppressors();
+        
+        // The tracked location of a zone track.
+        const cv::Point& location(const ZoneTrack& track) const;
+    public:
+        PartitionedTracker(cv::Size frameSize,
+                           int numZoneColumns,
+                           int numZoneRows,
+                           int overlap = 64);
+        
+        // Update the zone trackers with the mass centers of the observed bounding rects.
+        void update(const std::vector<cv::Point2f>& massCenters,
+                    const std::vector<cv::Rect>& boundingRects,
+                    std::vector<OT::TrackingOutput>& trackingOutputs);
+        
+        // Set the association of every zone by name. Returns false if there is no such association.
+        bool setAssociation(const std::string& name);
+        
+        // Whether every zone matches the unambiguous pairs before its association.
+        void setCascade(bool cascade);
+        
+        // The number of trackers a zone needs to update them in parallel (0 keeps them serial).
+        void setMinParallelTrackers(size_t minParallelTrackers);
+        
+        // The total time the zones spent associating trackers with mass centers.
+        double associationTime() const;
+        
+        int numZones() const;
+    };
+}
+
+#endif /* partitioned_tracker_h */
@@ -0,0 +1,74 @@
+#ifndef point_grid_h
+#define point_grid_h
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+namespace OT {
+    /**
+     * A uniform grid of square cells over a set of points, which finds the points in a
+     * rectangle by only looking at the cells the rectangle overlaps. It's rebuilt from scratch
+     * whenever the points move, which takes linear time (a counting sort by cell).
+     *
+     * The grid covers the bounding box of the points, so a rectangle that reaches outside of it
+     * is clipped to the border cells. The cells are made larger if there would otherwise be many
+     * more cells than points.
+     */
+    class PointGrid {
+    private:
+        std::vector<cv::Point> points;
+        
+        // The top left corner of the grid, the side length of a cell, and the number of
+        // cells across and down.
+        cv::Point origin;
+        int cellSize;
+        int numCellColumns;
+        int numCellRows;
+        
+        // The points in cell c (numbered row by row) are cellPoints[cellStart[c], cellStart[c + 1]).
+        std::vector<int> cellStart;
+        std::vector<int> cellPoints;
+        
+        // The column or row of the cell containing x or y, clamped to the grid.
+        int cellColumn(int x) const;
+        int cellRow(int y) const;
+    public:
+        PointGrid();
+        
+        // Index the points with cells of (at least) the given size.
+        void build(const std::vector<cv::Point>& points, int cellSize);
+        
+        /**
+         * Call f(index) for the points in the rectangle, in no particular order, until it returns
+         * true. Returns whether it did.
+         */
+        template <typename Function>
+        bool anyInRect(const cv::Rect& rect, Function f) const {
+            if (this->points.empty() || rect.width <= 0 || rect.height <= 0) {
+                return false;
+            }
+            int firstColumn = this->cellColumn(rect.x);
+            int lastColumn = this->cellColumn(rect.x + rect.width - 1);
+            int firstRow = this->cellRow(rect.y);
+            int lastRow = this->cellRow(rect.y + rect.height - 1);
+            for (int row = firstRow; row <= lastRow; row++) {
+                for (int column = firstColumn; column <= lastColumn; column++) {
+                    int c = row * this->numCellColumns + column;
+                    for (int k = this->cellStart[c]; k < this->cellStart[c + 1]; k++) {
+                        int index = this->cellPoints[k];
+                        if (rect.contains(this->points[index]) && f(index)) {
+                            return true;
+                        }
+                    }
+                }
+            }
+            return false;
+        }
+        
+        // The number of bytes reserved by the grid's buffers.
+        size_t reservedBytes() const;
+    };
+}
+
+#endif /* point_grid_h */
@@ -0,0 +1,247 @@
+#ifndef tracker_bank_h
+#define tracker_bank_h
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "tracker/tracking_output.hpp"
+
+namespace OT {
+    /**
+     * The Kalman trackers of a MultiObjectTracker, stored as a structure of arrays. Each tracker is
+     * an index into the bank, and each of its fields lives in its own contiguous array, so predict
+     * and correct run as one branch-free loop over all the trackers, which the compiler can
+     * vectorize.
+     *
+     * Every tracker uses a constant velocity model driven by random accelerations, with the
+     * whole-pixel mass centers as measurements. In that model x and y are independent and always get the same noise and the same updates, so both share one 2x2
+     * (position, velocity) covariance, which is stored as its three distinct entries.
+     *
+     * The covariance and gain don't depend on the measurements, so a tracker that is corrected
+     * every frame converges to a steady state that only depends on dt and the noise. It's found
+     * once per configuration for the whole process. A tracker whose covariance gets within
+     * steadyStateTolerance of it snaps to it, and then skips computing the covariance and gain
+     * until it misses an update.
+     *
+     * Removing trackers compacts the arrays, so a tracker's index changes; its ID doesn't. IDs
+     * come from a counter, so they never repeat within a bank.
+     */
+    class TrackerBank {
+    private:
+        // The time between frames.
+        float dt;
+        
+        // The process noise covariance of one axis (position variance, position-velocity
+        // covariance, velocity variance).
+        float processPosVar;
+        float processPosVelCov;
+        float processVelVar;
+        
+        // The magnitude of the acceleration noise, which the process noise is made of.
+        float magnitudeOfAccelerationNoise;
+        
+        // The measurement noise variance of one axis.
+        float measurementNoise;
+        
+        // How close (relative to each entry) the covariance has to be to the steady state to snap to it.
+        static constexpr float steadyStateTolerance = 1e-5;
+        
+        // The covariances and gain of a tracker that has converged.
+        struct SteadyState {
+            // Whether the covariance settled down.
+            bool exists;
+            
+            // The covariance after predicting and after correcting, and the gain.
+            float predictedPosVar;
+            float predictedPosVelCov;
+            float predictedVelVar;
+            float correctedPosVar;
+            float correctedPosVelCov;
+            float correctedVelVar;
+            float positionGain;
+            float velocityGain;
+        };
+        
+        // The steady state for this bank's configuration.
+        const SteadyState* steadyState;
+        
+        // Find the steady state for the configuration, computing it the first time it's seen.
+        static const SteadyState* findSteadyState(const TrackerBank& bank);
+        
+        // Where each tracker is relative to the steady state.
+        enum SteadyStage : unsigned char {
+            // The covariance isn't the steady state.
+            transient,
+            
+            // The covariance is the steady state covariance after correcting.
+            corrected,
+            
+            // The covariance is the steady state covariance after predicting.
+            predicted
+        };
+        
+        // The maximum number of points to store in each tracked object's trajectory.
+        size_t maxTrajectorySize;
+        
+        // The state of each tracker.
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> vx;
+        std::vector<float> vy;
+        
+        // The covariance of each tracker (shared by the x and y axes).
+        std::vector<float> posVar;
+        std::vector<float> posVelCov;
+        std::vector<float> velVar;
+        std::vector<SteadyStage> steadyStage;
+        
+        // The number of frames that each tracker has gone without having an update.
+        std::vector<int> numFramesWithoutUpdate;
+        
+        // The number of frames that each tracker has been alive.
+        std::vector<long> lifetime;
+        
+        // The latest prediction of each tracker.
+        std::vector<cv::Point> prediction;
+        
+        // The unique identifier and color of each tracker.
+        std::vector<int> id;
+        std::vector<cv::Scalar> color;
+        
+        // The ID of the next tracker to be added.
+        int nextId;
+        
+        // The trajectory of each tracked object.
+        std::vector<OT::Trajectory> trajectory;
+        
+        // What each tracker was matched with in the last incremental assignment, and the price
+        // of the column it was matched to.
+        std::vector<unsigned char> previousMatch;
+        std::vector<double> previousPrice;
+        
+        // Scratch space for predict and correct: which trackers to update (0 or 1), their
+        // measurements, and their gains.
+        std::vector<float> weight;
+        std::vector<float> measuredX;
+        std::vector<float> measuredY;
+        std::vector<float> positionGain;
+        std::vector<float> velocityGain;
+        
+        // Scratch space for latestTrackingOutputs: the trackers to output.
+        std::vector<int> outputTrackers;
+        
+        // Split the per-tracker loops into ranges updated in parallel when there are at least
+        // this many trackers (0 keeps them serial).
+        size_t minParallelTrackers;
+        
+        // Call f(start, end) on consecutive ranges of trackers covering [0, n), one per
+        // thread if there are enough trackers.
+        template <typename Function>
+        void forEachRange(size_t n, Function f);
+        
+        // Do predict or correct for trackers [start, end).
+        void predictRange(const std::vector<unsigned char>& shouldPredict, size_t start, size_t end);
+        void correctRange(const std::vector<int>& assignment,
+                          const std::vector<cv::Point2f>& massCenters,
+                          size_t start,
+                          size_t end);
+        
+        // Predict and correct the covariance of one tracker (either axis).
+        void predictCovariance(float& posVar, float& posVelCov, float& velVar) const;
+        void correctCovariance(float& posVar,
+                               float& posVelCov,
+                               float& velVar,
+                               float& positionGain,
+                               float& velocityGain) const;
+        
+        // Whether the covariance of tracker i is within tolerance of the steady state.
+        bool isNearSteadyState(size_t i) const;
+    public:
+        /**
+         * Trajectories keep at most maxTrajectorySize points, which can't be more than
+         * OT::Trajectory::capacity.
+         */
+        TrackerBank(float dt = 0.2,
+                    float magnitudeOfAccelerationNoise = 0.5,
+                    size_t maxTrajectorySize = 20);
+        
+        // The number of trackers in the bank.
+        size_t size() const;
+        
+        bool empty() const;
+        
+        // Add a tracker for an object at the given point. It goes at the end of the bank.
+        void add(cv::Point startPt);
+        
+        /**
+         * Add a copy of tracker i of another bank (with the same configuration) at the end of
+         * this one. It keeps its state, lifetime, color, and trajectory, but gets a new ID,
+         * which is returned.
+         */
+        int addCopy(const TrackerBank& source, size_t i);
+        
+        /**
+         * Remove every tracker i for which shouldRemove[i] is non-zero in one pass. The remaining
+         * trackers keep their order, and no memory is released, so adding trackers back later
+         * doesn't allocate.
+         */
+        void removeIf(const std::vector<unsigned char>& shouldRemove);
+        
+        // The number of bytes reserved by the bank's arrays.
+        size_t reservedBytes() const;
+        
+        /**
+         * Predict the next location of every tracker i for which shouldPredict[i] is non-zero
+         * (trackers past the end of shouldPredict aren't predicted).
+         */
+        void predict(const std::vector<unsigned char>& shouldPredict);
+        
+        /**
+         * Correct every tracker i for which assignment[i] isn't -1 with the mass center
+         * massCenters[assignment[i]] (trackers past the end of assignment aren't corrected).
+         */
+        void correct(const std::vector<int>& assignment, const std::vector<cv::Point2f>& massCenters);
+        
+        // Append the outputs of the trackers whose lifetime is above minLifetime, in order.
+        void latestTrackingOutputs(long minLifetime, std::vector<OT::TrackingOutput>& outputs);
+        
+        /**
+         * Run predict, correct, and latestTrackingOutputs on one range of trackers per thread
+         * when there are at least minParallelTrackers trackers (0, the default, keeps them
+         * serial). Every tracker is updated by the same code in either case, so the results
+         * are identical.
+         */
+        void setMinParallelTrackers(size_t minParallelTrackers);
+        
+        // Indicate that tracker i did not get an update this frame.
+        void noUpdateThisFrame(size_t i);
+        
+        // Indicate that tracker i was updated this frame.
+        void gotUpdate(size_t i);
+        
+        // What a tracker was matched with in the last incremental assignment.
+        enum PreviousMatch : unsigned char {
+            // The tracker hasn't been through an incremental assignment yet.
+            noPreviousMatch,
+            
+            matchedMassCenter,
+            
+            // There were more trackers than mass centers and this one didn't get any.
+            matchedNothing
+        };
+        
+        // Remember what tracker i was matched with, and at what price, to start the next assignment from.
+        void setPreviousMatch(size_t i, PreviousMatch match, double price);
+        PreviousMatch getPreviousMatch(size_t i) const;
+        double getPreviousPrice(size_t i) const;
+        
+        int getId(size_t i) const;
+        int getNumFramesWithoutUpdate(size_t i) const;
+        long getLifetime(size_t i) const;
+        cv::Point latestPrediction(size_t i) const;
+        OT::TrackingOutput latestTrackingOutput(size_t i) const;
+    };
+}
+
+#endif /* tracker_bank_h */
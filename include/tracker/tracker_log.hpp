@@ -5,6 +5,8 @@
 #include <vector>
 #include <fstream>
 
+#include "tracker/tracking_output.hpp"
+
 namespace OT {
     struct Track {
         int trackerId;
@@ -36,6 +38,9 @@ namespace OT {
         // Update the tracker log with the latest info for some tracker.
         void addTrack(int trackerId, int x, int y, long frameNumber);
         
+        // Update the tracker log with the latest location of a tracked object.
+        void addTrack(const OT::TrackingOutput& output, long frameNumber);
+        
         // Output the log to the given file as JSON.
         void logToFile(std::ofstream& outputStream);
         
@@ -0,0 +1,24 @@
+#ifndef tracking_output_h
+#define tracking_output_h
+
+#include <opencv2/opencv.hpp>
+
+#include "tracker/trajectory.hpp"
+
+namespace OT {
+    // What a tracker reports about the object it follows after an update.
+    struct TrackingOutput {
+        int id;
+        cv::Point location;
+        cv::Scalar color;
+        
+        // The number of frames the tracker has been updated (or predicted) for.
+        long lifetime;
+        
+        // The trajectory is a view into the tracker's own storage, so it is only valid until
+        // the tracker is updated again.
+        OT::TrajectoryView trajectory;
+    };
+}
+
+#endif /* tracking_output_h */
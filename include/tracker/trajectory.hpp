@@ -0,0 +1,93 @@
+#ifndef trajectory_h
+#define trajectory_h
+
+#include <algorithm>
+
+#include <opencv2/opencv.hpp>
+
+namespace OT {
+    /**
+     * A read-only view of the points of a trajectory, oldest first. The points live in a ring
+     * buffer owned by someone else (e.g. a Trajectory), so the view is only valid until that
+     * trajectory changes.
+     */
+    class TrajectoryView {
+    private:
+        // The ring buffer.
+        const cv::Point* points;
+        size_t capacity;
+        
+        // The index of the oldest point in the ring buffer, and the number of points.
+        size_t head;
+        size_t count;
+    public:
+        TrajectoryView() : points(nullptr), capacity(0), head(0), count(0) {
+        }
+        
+        TrajectoryView(const cv::Point* points, size_t capacity, size_t head, size_t count) :
+        points(points), capacity(capacity), head(head), count(count) {
+        }
+        
+        size_t size() const {
+            return this->count;
+        }
+        
+        bool empty() const {
+            return this->count == 0;
+        }
+        
+        // The i-th oldest point.
+        const cv::Point& operator[](size_t i) const {
+            size_t index = this->head + i;
+            return this->points[index < this->capacity ? index : index - this->capacity];
+        }
+    };
+    
+    /**
+     * The most recent points of a trajectory, kept in a fixed-capacity ring buffer inside the
+     * object. Adding a point to a full trajectory overwrites the oldest point.
+     */
+    class Trajectory {
+    public:
+        // The most points a trajectory can hold.
+        static constexpr size_t capacity = 64;
+    private:
+        cv::Point points[capacity];
+        
+        // The index of the oldest point, and the number of points.
+        size_t head;
+        size_t count;
+        
+        // The number of points to keep.
+        size_t maxSize;
+    public:
+        /**
+         * Keeps the last maxSize points, which can't be more than capacity.
+         */
+        explicit Trajectory(size_t maxSize = 20) : head(0), count(0) {
+            CV_Assert(maxSize <= capacity);
+            this->maxSize = std::max<size_t>(maxSize, 1);
+        }
+        
+        void push_back(cv::Point pt) {
+            if (this->count < this->maxSize) {
+                size_t index = this->head + this->count;
+                this->points[index < this->maxSize ? index : index - this->maxSize] = pt;
+                this->count++;
+            } else {
+                this->points[this->head] = pt;
+                this->head = (this->head + 1 == this->maxSize) ? 0 : this->head + 1;
+            }
+        }
+        
+        size_t size() const {
+            return this->count;
+        }
+        
+        TrajectoryView view() const {
+            return TrajectoryView(this->points, this->maxSize, this->head, this->count);
+        }
+    };
+}
+
+#endif /* trajectory_h */
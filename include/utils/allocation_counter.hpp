@@ -0,0 +1,23 @@
+#ifndef allocation_counter_h
+#define allocation_counter_h
+
+namespace OT {
+    namespace AllocationCounter {
+        /**
+         * Whether allocations are counted. Only the benchmark executable replaces operator new
+         * with versions that count, so that the main program keeps the default allocator.
+         */
+        bool isCounting();
+        
+        /**
+         * The number of times any thread has allocated with operator new (or new[]), or 0 if
+         * allocations aren't counted. That covers the standard containers and anything else
+         * created with new, including on cv::parallel_for_'s worker threads, but not memory
+         * OpenCV takes straight from malloc (such as cv::Mat data). Comparing the count before
+         * and after a call shows whether the call (or another thread meanwhile) allocated.
+         */
+        long count();
+    }
+}
+
+#endif /* allocation_counter_h */
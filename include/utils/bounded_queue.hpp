@@ -0,0 +1,159 @@
+#ifndef bounded_queue_h
+#define bounded_queue_h
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace OT {
+    /**
+     * Statistics collected by a BoundedQueue over its lifetime.
+     */
+    struct QueueStats {
+        // The maximum number of items the queue may hold.
+        size_t capacity;
+        
+        // The largest number of items that were ever in the queue.
+        size_t maxDepth;
+        
+        // The average number of items in the queue, sampled at each push.
+        double meanDepth;
+        
+        // Total time producers spent waiting because the queue was full.
+        double pushStallSeconds;
+        
+        // Total time consumers spent waiting because the queue was empty.
+        double popStallSeconds;
+        
+        // The number of items that went through the queue.
+        long numItems;
+    };
+    
+    /**
+     * A thread-safe FIFO queue with a fixed capacity. Producers block while the queue is
+     * full and consumers block while it is empty. Once the queue is closed, push fails and
+     * pop fails as soon as the remaining items have been drained.
+     */
+    template <typename T>
+    class BoundedQueue {
+    private:
+        typedef std::chrono::steady_clock Clock;
+        
+        // The items in the queue.
+        std::deque<T> items;
+        
+        // The maximum number of items in the queue.
+        size_t capacity;
+        
+        // Whether close() has been called.
+        bool closed;
+        
+        // Guards everything in this object.
+        mutable std::mutex mutex;
+        std::condition_variable notFull;
+        std::condition_variable notEmpty;
+        
+        // Accumulated statistics.
+        size_t maxDepth;
+        double depthSum;
+        double pushStallSeconds;
+        double popStallSeconds;
+        long numItems;
+        
+        static double secondsSince(Clock::time_point start) {
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        }
+    public:
+        explicit BoundedQueue(size_t capacity) {
+            this->capacity = std::max<size_t>(capacity, 1);
+            this->closed = false;
+            this->maxDepth = 0;
+            this->depthSum = 0;
+            this->pushStallSeconds = 0;
+            this->popStallSeconds = 0;
+            this->numItems = 0;
+        }
+        
+        /**
+         * Add an item to the back of the queue, waiting for space if needed.
+         * Returns false (and drops the item) if the queue has been closed.
+         */
+        bool push(T item) {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            if (this->items.size() >= this->capacity && !this->closed) {
+                auto start = Clock::now();
+                this->notFull.wait(lock, [this]() {
+                    return this->items.size() < this->capacity || this->closed;
+                });
+                this->pushStallSeconds += secondsSince(start);
+            }
+            if (this->closed) {
+                return false;
+            }
+            this->items.push_back(std::move(item));
+            this->numItems++;
+            this->depthSum += this->items.size();
+            this->maxDepth = std::max(this->maxDepth, this->items.size());
+            lock.unlock();
+            this->notEmpty.notify_one();
+            return true;
+        }
+        
+        /**
+         * Remove the item at the front of the queue, waiting for one if needed.
+         * Returns false if the queue is closed and has no items left.
+         */
+        bool pop(T& item) {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            if (this->items.empty() && !this->closed) {
+                auto start = Clock::now();
+                this->notEmpty.wait(lock, [this]() {
+                    return !this->items.empty() || this->closed;
+                });
+                this->popStallSeconds += secondsSince(start);
+            }
+            if (this->items.empty()) {
+                return false;
+            }
+            item = std::move(this->items.front());
+            this->items.pop_front();
+            lock.unlock();
+            this->notFull.notify_one();
+            return true;
+        }
+        
+        /**
+         * Stop accepting items and wake up everyone who is waiting on the queue.
+         */
+        void close() {
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->closed = true;
+            }
+            this->notFull.notify_all();
+            this->notEmpty.notify_all();
+        }
+        
+        // The number of items currently in the queue.
+        size_t size() const {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            return this->items.size();
+        }
+        
+        QueueStats stats() const {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            return QueueStats{
+                this->capacity,
+                this->maxDepth,
+                this->numItems == 0 ? 0 : this->depthSum / this->numItems,
+                this->pushStallSeconds,
+                this->popStallSeconds,
+                this->numItems
+            };
+        }
+    };
+}
+
+#endif /* bounded_queue_h */
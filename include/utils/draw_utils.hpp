@@ -5,6 +5,8 @@
 
 #include <opencv2/opencv.hpp>
 
+#include "tracker/trajectory.hpp"
+
 namespace OT {
   namespace DrawUtils {
     /**
@@ -24,11 +26,11 @@ namespace OT {
                             const cv::Rect& boundingRect);
       
       void drawTrajectory(const cv::Mat& img,
-                          const std::vector<cv::Point>& trajectory,
+                          const OT::TrajectoryView& trajectory,
                           const cv::Scalar color);
       
       /**
-       * Draw the contours in a new image and show them.
+       * Draw the contours and bounding rectangles in a new image and show them.
        */
       void contourShow(std::string drawingName,
                        const std::vector<std::vector<cv::Point>>& contours,
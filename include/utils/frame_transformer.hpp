@@ -0,0 +1,112 @@
+#ifndef frame_transformer_h
+#define frame_transformer_h
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+namespace OT {
+    /**
+     * Applies the optional perspective transform and the optional downscaling to each frame.
+     * When there's a perspective transform, both steps are fused into a single remap pass
+     * using fixed-point lookup tables computed once, so the full resolution warp is never
+     * materialized.
+     *
+     * Alternatively, the transformer can leave the perspective out of the frames entirely and
+     * only scale them. Detections found in those frames are then mapped into the perspective
+     * transformed (and scaled) coordinates with transformDetections.
+     *
+     * Optionally, the transformed frames are converted to grayscale so that everything
+     * downstream (i.e. background subtraction) only has to deal with a single channel.
+     */
+    class FrameTransformer {
+    private:
+        // Whether a perspective transform was given.
+        bool hasPerspective;
+        
+        // Whether the perspective transform is applied to detections instead of frames.
+        bool warpDetections;
+        
+        // Whether the transformed frames only keep the luma (i.e. are grayscale).
+        bool luma;
+        
+        // The transformed frame before it's converted to grayscale.
+        cv::Mat colorFrame;
+        
+        // The perspective transform and the size of the frame after it is applied.
+        cv::Mat perspectiveMatrix;
+        cv::Size perspectiveSize;
+        
+        // Scale frames so that neither # rows nor # cols exceed this value (-1 to disable).
+        int maxDimension;
+        
+        // The size of the perspective transformed and scaled frames.
+        cv::Size outputSize;
+        
+        // The fixed-point remap tables (integer coordinates and interpolation weights).
+        cv::Mat mapXY;
+        cv::Mat mapInterpolation;
+        
+        // Maps points in the scaled (but not perspective transformed) frame into the output
+        // coordinates, and back. Computed on the first frame when warping detections.
+        cv::Mat detectionMatrix;
+        cv::Mat detectionMatrixInverse;
+        
+        // Scratch space for the bounding box corners.
+        std::vector<cv::Point2f> corners;
+        
+        // Fill in the remap tables for the perspective transform combined with the scaling.
+        void buildRemapTables();
+    public:
+        /**
+         * perspectivePoints - The 8 ints from the command line (or empty if there's no perspective transform).
+         * maxDimension - See OT::Utils::scale.
+         * warpDetections - If true, frames are only scaled and the perspective transform is
+         *                  applied to detections with transformDetections instead.
+         * luma - If true, the transformed frames are single channel grayscale images.
+         */
+        FrameTransformer(const std::vector<int>& perspectivePoints,
+                         int maxDimension,
+                         bool warpDetections = false,
+                         bool luma = false);
+        
+        /**
+         * Transform the frame. The output may not alias the input.
+         */
+        void transform(const cv::Mat& frame, cv::Mat& output);
+        
+        /**
+         * Map the mass centers and bounding boxes found in a transformed frame into the
+         * perspective transformed coordinates. Detections that land outside of the perspective
+         * transformed frame are removed. This does nothing unless detections are being warped.
+         */
+        void transformDetections(std::vector<cv::Point2f>& massCenters,
+                                 std::vector<cv::Rect>& boundingBoxes);
+        
+        /**
+         * Map a rectangle in the perspective transformed coordinates back into the transformed
+         * frame (i.e. the inverse of transformDetections).
+         */
+        cv::Rect rectToFrame(const cv::Rect& rect) const;
+        
+        /**
+         * Apply the perspective transform to a transformed frame so it can be shown alongside the
+         * output of transformDetections. Grayscale frames are converted back to BGR so that colors
+         * can be drawn on them. Otherwise, this just copies the frame header.
+         */
+        void rectify(const cv::Mat& frame, cv::Mat& output) const;
+        
+        /**
+         * The size of the coordinate space that detections are in, given the size of a transformed frame.
+         */
+        cv::Size detectionSize(cv::Size frameSize) const;
+        
+        // Whether a perspective transform was given.
+        bool hasPerspectiveTransform() const;
+        
+        // Whether the perspective transform is applied to detections instead of frames.
+        bool isWarpingDetections() const;
+    };
+}
+
+#endif /* frame_transformer_h */
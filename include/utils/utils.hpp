@@ -8,14 +8,20 @@ namespace OT {
         /**
          * Check if there's another frame in the video capture. We do this by first checking if the user has quit (i.e. pressed
          * the "Q" key) and then trying to retrieve the next frame of the video.
+         * If headless is true, the keyboard is never polled (and no window needs to exist).
          */
-        bool hasFrame(cv::VideoCapture& capture);
+        bool hasFrame(cv::VideoCapture& capture, bool headless = false);
         /**
          * Resize the image so that neither # rows nor # cols exceed maxDimension.
          * Preserve the aspect ratio though.
          * Set maxDimension = -1 if you don't want to do any scaling.
          */
         void scale(cv::Mat& img, int maxDimension);
+        
+        /**
+         * The size that OT::Utils::scale would resize an image of the given size to.
+         */
+        cv::Size scaledSize(cv::Size size, int maxDimension);
     }
 }
 
@@ -21,80 +21,45 @@ DisjointSets::DisjointSets(int count)
     AddElements(count);
 }
 
-DisjointSets::DisjointSets(const DisjointSets & s)
-{
-    this->m_numElements = s.m_numElements;
-    this->m_numSets = s.m_numSets;
-    
-    // Copy nodes
-    m_nodes.resize(m_numElements);
-    for(int i = 0; i < m_numElements; ++i)
-        m_nodes[i] = new Node(*s.m_nodes[i]);
-    
-    // Update parent pointers to point to newly created nodes rather than the old ones
-    for(int i = 0; i < m_numElements; ++i)
-        if(m_nodes[i]->parent != NULL)
-            m_nodes[i]->parent = m_nodes[s.m_nodes[i]->parent->index];
-}
-
-DisjointSets::~DisjointSets()
-{
-    for(int i = 0; i < m_numElements; ++i)
-        delete m_nodes[i];
-    m_nodes.clear();
-    m_numElements = 0;
-    m_numSets = 0;
-}
-
 // Note: some internal data is modified for optimization even though this method is consant.
 int DisjointSets::FindSet(int elementId) const
 {
     assert(elementId < m_numElements);
     
-    Node* curNode;
-    
-    // Find the root element that represents the set which `elementId` belongs to
-    curNode = m_nodes[elementId];
-    while(curNode->parent != NULL)
-        curNode = curNode->parent;
-    Node* root = curNode;
-    
-    // Walk to the root, updating the parents of `elementId`. Make those elements the direct
-    // children of `root`. This optimizes the tree for future FindSet invokations.
-    curNode = m_nodes[elementId];
-    while(curNode != root)
+    // Walk to the root, pointing every other element on the way at its grandparent (path halving).
+    // This optimizes the tree for future FindSet invokations.
+    while(m_parent[elementId] != elementId)
     {
-        Node* next = curNode->parent;
-        curNode->parent = root;
-        curNode = next;
+        m_parent[elementId] = m_parent[m_parent[elementId]];
+        elementId = m_parent[elementId];
     }
     
-    return root->index;
+    return elementId;
 }
 
-void DisjointSets::Union(int setId1, int setId2)
+void DisjointSets::Union(int elementId1, int elementId2)
 {
-    assert(setId1 < m_numElements);
-    assert(setId2 < m_numElements);
+    assert(elementId1 < m_numElements);
+    assert(elementId2 < m_numElements);
     
-    if(setId1 == setId2)
-        return; // already unioned
+    int set1 = FindSet(elementId1);
+    int set2 = FindSet(elementId2);
     
-    Node* set1 = m_nodes[setId1];
-    Node* set2 = m_nodes[setId2];
+    if(set1 == set2)
+        return; // already unioned
     
     // Determine which node representing a set has a higher rank. The node with the higher rank is
     // likely to have a bigger subtree so in order to better balance the tree representing the
     // union, the node with the higher rank is made the parent of the one with the lower rank and
     // not the other way around.
-    if(set1->rank > set2->rank)
-        set2->parent = set1;
-    else if(set1->rank < set2->rank)
-        set1->parent = set2;
-    else // set1->rank == set2->rank
+    if(m_rank[set1] > m_rank[set2])
+        m_parent[set2] = set1;
+    else if(m_rank[set1] < m_rank[set2])
+        m_parent[set1] = set2;
+    else // m_rank[set1] == m_rank[set2]
     {
-        set2->parent = set1;
-        ++set1->rank; // update rank
+        m_parent[set2] = set1;
+        ++m_rank[set1]; // update rank
     }
     
     // Since two sets have fused into one, there is now one less set so update the set count.
@@ -105,14 +70,11 @@ void DisjointSets::AddElements(int numToAdd)
 {
     assert(numToAdd >= 0);
     
-    // insert and initialize the specified number of element nodes to the end of the `m_nodes` array
-    m_nodes.insert(m_nodes.end(), numToAdd, (Node*)NULL);
+    // append the specified number of singleton elements to the end of the arrays
     for(int i = m_numElements; i < m_numElements + numToAdd; ++i)
     {
-        m_nodes[i] = new Node();
-        m_nodes[i]->parent = NULL;
-        m_nodes[i]->index = i;
-        m_nodes[i]->rank = 0;
+        m_parent.push_back(i);
+        m_rank.push_back(0);
     }
     
     // update element and set counts
@@ -120,6 +82,36 @@ void DisjointSets::AddElements(int numToAdd)
     m_numSets += numToAdd;
 }
 
+void DisjointSets::Reset(int count)
+{
+    assert(count >= 0);
+    
+    // clear() keeps the capacity, so this doesn't allocate unless count is bigger than ever before
+    m_parent.clear();
+    m_rank.clear();
+    m_numElements = 0;
+    m_numSets = 0;
+    AddElements(count);
+}
+
+int DisjointSets::CompactSetIds(std::vector<int>& setIds) const
+{
+    // m_compactIds maps a root to its compact id (or -1 if we haven't seen it yet)
+    m_compactIds.assign(m_numElements, -1);
+    setIds.resize(m_numElements);
+    
+    int numSets = 0;
+    for(int i = 0; i < m_numElements; ++i)
+    {
+        int root = FindSet(i);
+        if(m_compactIds[root] == -1)
+            m_compactIds[root] = numSets++;
+        setIds[i] = m_compactIds[root];
+    }
+    
+    return numSets;
+}
+
 int DisjointSets::NumElements() const
 {
     return m_numElements;
@@ -129,3 +121,8 @@ int DisjointSets::NumSets() const
 {
     return m_numSets;
 }
+
+size_t DisjointSets::ReservedBytes() const
+{
+    return (m_parent.capacity() + m_rank.capacity() + m_compactIds.capacity()) * sizeof(int);
+}
@@ -1,11 +1,18 @@
 #include "lib/hungarian.hpp"
 
-#define DBL_MAX 100000
+#include <algorithm>
+#include <cmath>
+
+#include <opencv2/opencv.hpp>
+
+// The cost the Munkres and suboptimal solvers use for pairs that have been ruled out.
+static const double kForbiddenCost = 100000;
 
 using namespace std;
 
 AssignmentProblemSolver::AssignmentProblemSolver()
 {
+    auctionTolerance = 1e-6;
 }
 
 AssignmentProblemSolver::~AssignmentProblemSolver()
@@ -14,13 +21,17 @@ AssignmentProblemSolver::~AssignmentProblemSolver()
 
 double AssignmentProblemSolver::Solve(vector<vector<double> >& DistMatrix,vector<int>& Assignment,TMethod Method)
 {
-    int N=DistMatrix.size(); // number of columns (tracks)
-    int M=DistMatrix[0].size(); // number of rows (measurements)
+    return Solve(DistMatrix, DistMatrix.size(), DistMatrix[0].size(), Assignment, Method);
+}
+
+double AssignmentProblemSolver::Solve(const vector<vector<double> >& DistMatrix,int nOfRows,int nOfColumns,vector<int>& Assignment,TMethod Method)
+{
+    int N=nOfRows; // number of columns (tracks)
+    int M=nOfColumns; // number of rows (measurements)
     
-    int *assignment		=new int[N];
-    double *distIn		=new double[N*M];
+    distInBuffer.resize(N*M);
+    double *distIn		=distInBuffer.data();
     
-    double  cost;
     // Fill matrix with random numbers
     for(int i=0; i<N; i++)
     {
@@ -29,37 +40,62 @@ double AssignmentProblemSolver::Solve(vector<vector<double> >& DistMatrix,vector
             distIn[i+N*j] = DistMatrix[i][j];
         }
     }
+    return solve(distIn, 1, N, N, M, Assignment, workspace, Method);
+}
+
+template <typename T>
+T AssignmentProblemSolver::Solve(const T *Costs,int nOfRows,int nOfColumns,size_t RowStride,vector<int>& Assignment,AssignmentWorkspace<T>& Workspace,TMethod Method)
+{
+    return solve(Costs, RowStride, 1, nOfRows, nOfColumns, Assignment, Workspace, Method);
+}
+
+template <typename T>
+T AssignmentProblemSolver::solve(const T *distMatrixIn, size_t rowStride, size_t colStride, int nOfRows, int nOfColumns, vector<int>& Assignment, AssignmentWorkspace<T>& workspace, TMethod Method)
+{
+    workspace.assignment.resize(nOfRows);
+    int *assignment = workspace.assignment.data();
+    
+    T cost;
     switch(Method)
     {
-        case optimal: assignmentoptimal(assignment, &cost, distIn, N, M); break;
+        case optimal: assignmentoptimal(assignment, &cost, distMatrixIn, rowStride, colStride, nOfRows, nOfColumns, workspace); break;
             
-        case many_forbidden_assignments: assignmentoptimal(assignment, &cost, distIn, N, M); break;
+        case many_forbidden_assignments: assignmentoptimal(assignment, &cost, distMatrixIn, rowStride, colStride, nOfRows, nOfColumns, workspace); break;
             
-        case without_forbidden_assignments: assignmentoptimal(assignment, &cost, distIn, N, M); break;
+        case without_forbidden_assignments: assignmentoptimal(assignment, &cost, distMatrixIn, rowStride, colStride, nOfRows, nOfColumns, workspace); break;
+            
+        case jonker_volgenant: assignmentjv(assignment, &cost, distMatrixIn, rowStride, colStride, nOfRows, nOfColumns, workspace); break;
+            
+        case auction: assignmentauction(assignment, &cost, distMatrixIn, rowStride, colStride, nOfRows, nOfColumns, workspace); break;
     }
     
     // form result
-    Assignment.clear();
-    for(int x=0; x<N; x++)
-    {
-        Assignment.push_back(assignment[x]);
-    }
+    Assignment.assign(assignment, assignment + nOfRows);
     
-    delete[] assignment;
-    delete[] distIn;
     return cost;
 }
+
+size_t AssignmentProblemSolver::reservedBytes() const
+{
+    return distInBuffer.capacity() * sizeof(double) + workspace.reservedBytes();
+}
+
+void AssignmentProblemSolver::SetAuctionTolerance(double Tolerance)
+{
+    auctionTolerance = Tolerance;
+}
 // --------------------------------------------------------------------------
 // Computes the optimal assignment (minimum overall costs) using Munkres algorithm.
 // --------------------------------------------------------------------------
-void AssignmentProblemSolver::assignmentoptimal(int *assignment, double *cost, double *distMatrixIn, int nOfRows, int nOfColumns)
+template <typename T>
+void AssignmentProblemSolver::assignmentoptimal(int *assignment, T *cost, const T *distMatrixIn, size_t rowStride, size_t colStride, int nOfRows, int nOfColumns, AssignmentWorkspace<T>& workspace)
 {
-    double *distMatrix;
-    double *distMatrixTemp;
-    double *distMatrixEnd;
-    double *columnEnd;
-    double  value;
-    double  minValue;
+    T *distMatrix;
+    T *distMatrixTemp;
+    T *distMatrixEnd;
+    T *columnEnd;
+    T  value;
+    T  minValue;
     
     bool *coveredColumns;
     bool *coveredRows;
@@ -84,28 +120,39 @@ void AssignmentProblemSolver::assignmentoptimal(int *assignment, double *cost, d
     
     // Total elements number
     nOfElements   = nOfRows * nOfColumns;
-    // Memory allocation
-    distMatrix    = (double *)malloc(nOfElements * sizeof(double));
+    // Memory allocation (reusing the buffers from the last call if they're big enough)
+    workspace.distMatrix.resize(nOfElements);
+    distMatrix    = workspace.distMatrix.data();
     // Pointer to last element
     distMatrixEnd = distMatrix + nOfElements;
     
-    //
-    for(row=0; row<nOfElements; row++)
+    // Copy the costs into the column-major working matrix
+    for(col=0; col<nOfColumns; col++)
     {
-        value = distMatrixIn[row];
-        if(value < 0)
+        for(row=0; row<nOfRows; row++)
         {
-            cout << "All matrix elements have to be non-negative." << endl;
+            value = distMatrixIn[row*rowStride + col*colStride];
+            if(value < 0)
+            {
+                cout << "All matrix elements have to be non-negative." << endl;
+            }
+            distMatrix[row + nOfRows*col] = value;
         }
-        distMatrix[row] = value;
     }
     
     // Memory allocation
-    coveredColumns = (bool *)calloc(nOfColumns,  sizeof(bool));
-    coveredRows    = (bool *)calloc(nOfRows,     sizeof(bool));
-    starMatrix     = (bool *)calloc(nOfElements, sizeof(bool));
-    primeMatrix    = (bool *)calloc(nOfElements, sizeof(bool));
-    newStarMatrix  = (bool *)calloc(nOfElements, sizeof(bool)); /* used in step4 */
+    size_t nOfBools = nOfColumns + nOfRows + 3 * (size_t)nOfElements;
+    if(nOfBools > workspace.boolsSize)
+    {
+        workspace.bools.reset(new bool[nOfBools]);
+        workspace.boolsSize = nOfBools;
+    }
+    std::fill(workspace.bools.get(), workspace.bools.get() + nOfBools, false);
+    coveredColumns = workspace.bools.get();
+    coveredRows    = coveredColumns + nOfColumns;
+    starMatrix     = coveredRows + nOfRows;
+    primeMatrix    = starMatrix + nOfElements;
+    newStarMatrix  = primeMatrix + nOfElements; /* used in step4 */
     
     /* preliminary steps */
     if(nOfRows <= nOfColumns)
@@ -201,14 +248,7 @@ void AssignmentProblemSolver::assignmentoptimal(int *assignment, double *cost, d
     /* move to step 2b */
     step2b(assignment, distMatrix, starMatrix, newStarMatrix, primeMatrix, coveredColumns, coveredRows, nOfRows, nOfColumns, minDim);
     /* compute cost and remove invalid assignments */
-    computeassignmentcost(assignment, cost, distMatrixIn, nOfRows);
-    /* free allocated memory */
-    free(distMatrix);
-    free(coveredColumns);
-    free(coveredRows);
-    free(starMatrix);
-    free(primeMatrix);
-    free(newStarMatrix);
+    computeassignmentcost(assignment, cost, distMatrixIn, rowStride, colStride, nOfRows);
     return;
 }
 // --------------------------------------------------------------------------
@@ -232,7 +272,8 @@ void AssignmentProblemSolver::buildassignmentvector(int *assignment, bool *starM
 // --------------------------------------------------------------------------
 //
 // --------------------------------------------------------------------------
-void AssignmentProblemSolver::computeassignmentcost(int *assignment, double *cost, double *distMatrix, int nOfRows)
+template <typename T>
+void AssignmentProblemSolver::computeassignmentcost(int *assignment, T *cost, const T *distMatrix, size_t rowStride, size_t colStride, int nOfRows)
 {
     int row, col;
     for(row=0; row<nOfRows; row++)
@@ -240,7 +281,7 @@ void AssignmentProblemSolver::computeassignmentcost(int *assignment, double *cos
         col = assignment[row];
         if(col >= 0)
         {
-            *cost += distMatrix[row + nOfRows*col];
+            *cost += distMatrix[row*rowStride + col*colStride];
         }
     }
 }
@@ -248,7 +289,8 @@ void AssignmentProblemSolver::computeassignmentcost(int *assignment, double *cos
 // --------------------------------------------------------------------------
 //
 // --------------------------------------------------------------------------
-void AssignmentProblemSolver::step2a(int *assignment, double *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim)
+template <typename T>
+void AssignmentProblemSolver::step2a(int *assignment, T *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim)
 {
     bool *starMatrixTemp, *columnEnd;
     int col;
@@ -273,7 +315,8 @@ void AssignmentProblemSolver::step2a(int *assignment, double *distMatrix, bool *
 // --------------------------------------------------------------------------
 //
 // --------------------------------------------------------------------------
-void AssignmentProblemSolver::step2b(int *assignment, double *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim)
+template <typename T>
+void AssignmentProblemSolver::step2b(int *assignment, T *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim)
 {
     int col, nOfCoveredColumns;
     /* count covered columns */
@@ -300,7 +343,8 @@ void AssignmentProblemSolver::step2b(int *assignment, double *distMatrix, bool *
 // --------------------------------------------------------------------------
 //
 // --------------------------------------------------------------------------
-void AssignmentProblemSolver::step3(int *assignment, double *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim)
+template <typename T>
+void AssignmentProblemSolver::step3(int *assignment, T *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim)
 {
     bool zerosFound;
     int row, col, starCol;
@@ -349,7 +393,8 @@ void AssignmentProblemSolver::step3(int *assignment, double *distMatrix, bool *s
 // --------------------------------------------------------------------------
 //
 // --------------------------------------------------------------------------
-void AssignmentProblemSolver::step4(int *assignment, double *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim, int row, int col)
+template <typename T>
+void AssignmentProblemSolver::step4(int *assignment, T *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim, int row, int col)
 {
     int n, starRow, starCol, primeRow, primeCol;
     int nOfElements = nOfRows*nOfColumns;
@@ -412,12 +457,13 @@ void AssignmentProblemSolver::step4(int *assignment, double *distMatrix, bool *s
 // --------------------------------------------------------------------------
 //
 // --------------------------------------------------------------------------
-void AssignmentProblemSolver::step5(int *assignment, double *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim)
+template <typename T>
+void AssignmentProblemSolver::step5(int *assignment, T *distMatrix, bool *starMatrix, bool *newStarMatrix, bool *primeMatrix, bool *coveredColumns, bool *coveredRows, int nOfRows, int nOfColumns, int minDim)
 {
-    double h, value;
+    T h, value;
     int row, col;
     /* find smallest uncovered element h */
-    h = DBL_MAX;
+    h = kForbiddenCost;
     for(row=0; row<nOfRows; row++)
     {
         if(!coveredRows[row])
@@ -490,12 +536,12 @@ void AssignmentProblemSolver::assignmentsuboptimal2(int *assignment, double *cos
     while(true)
     {
         /* find minimum distance observation-to-track pair */
-        minValue = DBL_MAX;
+        minValue = kForbiddenCost;
         for(row=0; row<nOfRows; row++)
             for(col=0; col<nOfColumns; col++)
             {
                 value = distMatrix[row + nOfRows*col];
-                if(value!=DBL_MAX && (value < minValue))
+                if(value!=kForbiddenCost && (value < minValue))
                 {
                     minValue = value;
                     tmpRow   = row;
@@ -503,17 +549,17 @@ void AssignmentProblemSolver::assignmentsuboptimal2(int *assignment, double *cos
                 }
             }
         
-        if(minValue!=DBL_MAX)
+        if(minValue!=kForbiddenCost)
         {
             assignment[tmpRow] = tmpCol;
             *cost += minValue;
             for(n=0; n<nOfRows; n++)
             {
-                distMatrix[n + nOfRows*tmpCol] = DBL_MAX;
+                distMatrix[n + nOfRows*tmpCol] = kForbiddenCost;
             }
             for(n=0; n<nOfColumns; n++)
             {
-                distMatrix[tmpRow + nOfRows*n] = DBL_MAX;
+                distMatrix[tmpRow + nOfRows*n] = kForbiddenCost;
             }
         }
         else
@@ -560,7 +606,7 @@ void AssignmentProblemSolver::assignmentsuboptimal1(int *assignment, double *cos
     {
         for(col=0; col<nOfColumns; col++)
         {
-            if(distMatrix[row + nOfRows*col]!=DBL_MAX)
+            if(distMatrix[row + nOfRows*col]!=kForbiddenCost)
             {
                 nOfValidTracks[col]       += 1;
                 nOfValidObservations[row] += 1;
@@ -588,7 +634,7 @@ void AssignmentProblemSolver::assignmentsuboptimal1(int *assignment, double *cos
             {
                 singleValidationFound = false;
                 for(row=0; row<nOfRows; row++)
-                    if(distMatrix[row + nOfRows*col]!=DBL_MAX && (nOfValidObservations[row] == 1))
+                    if(distMatrix[row + nOfRows*col]!=kForbiddenCost && (nOfValidObservations[row] == 1))
                     {
                         singleValidationFound = true;
                         break;
@@ -597,9 +643,9 @@ void AssignmentProblemSolver::assignmentsuboptimal1(int *assignment, double *cos
                 if(singleValidationFound)
                 {
                     for(row=0; row<nOfRows; row++)
-                        if((nOfValidObservations[row] > 1) && distMatrix[row + nOfRows*col]!=DBL_MAX)
+                        if((nOfValidObservations[row] > 1) && distMatrix[row + nOfRows*col]!=kForbiddenCost)
                         {
-                            distMatrix[row + nOfRows*col] = DBL_MAX;
+                            distMatrix[row + nOfRows*col] = kForbiddenCost;
                             nOfValidObservations[row] -= 1;
                             nOfValidTracks[col]       -= 1;
                             repeatSteps = true;
@@ -615,7 +661,7 @@ void AssignmentProblemSolver::assignmentsuboptimal1(int *assignment, double *cos
                     singleValidationFound = false;
                     for(col=0; col<nOfColumns; col++)
                     {
-                        if(distMatrix[row + nOfRows*col]!=DBL_MAX && (nOfValidTracks[col] == 1))
+                        if(distMatrix[row + nOfRows*col]!=kForbiddenCost && (nOfValidTracks[col] == 1))
                         {
                             singleValidationFound = true;
                             break;
@@ -626,9 +672,9 @@ void AssignmentProblemSolver::assignmentsuboptimal1(int *assignment, double *cos
                     {
                         for(col=0; col<nOfColumns; col++)
                         {
-                            if((nOfValidTracks[col] > 1) && distMatrix[row + nOfRows*col]!=DBL_MAX)
+                            if((nOfValidTracks[col] > 1) && distMatrix[row + nOfRows*col]!=kForbiddenCost)
                             {
-                                distMatrix[row + nOfRows*col] = DBL_MAX;
+                                distMatrix[row + nOfRows*col] = kForbiddenCost;
                                 nOfValidObservations[row] -= 1;
                                 nOfValidTracks[col]       -= 1;
                                 repeatSteps = true;								
@@ -646,11 +692,11 @@ void AssignmentProblemSolver::assignmentsuboptimal1(int *assignment, double *cos
             if(nOfValidObservations[row] > 1)
             {
                 allSinglyValidated = true;
-                minValue = DBL_MAX;
+                minValue = kForbiddenCost;
                 for(col=0; col<nOfColumns; col++)
                 {
                     value = distMatrix[row + nOfRows*col];
-                    if(value!=DBL_MAX)
+                    if(value!=kForbiddenCost)
                     {
                         if(nOfValidTracks[col] > 1)
                         {
@@ -671,11 +717,11 @@ void AssignmentProblemSolver::assignmentsuboptimal1(int *assignment, double *cos
                     *cost += minValue;
                     for(n=0; n<nOfRows; n++)
                     {
-                        distMatrix[n + nOfRows*tmpCol] = DBL_MAX;
+                        distMatrix[n + nOfRows*tmpCol] = kForbiddenCost;
                     }
                     for(n=0; n<nOfColumns; n++)
                     {
-                        distMatrix[row + nOfRows*n] = DBL_MAX;
+                        distMatrix[row + nOfRows*n] = kForbiddenCost;
                     }
                 }
             }
@@ -688,11 +734,11 @@ void AssignmentProblemSolver::assignmentsuboptimal1(int *assignment, double *cos
             if(nOfValidTracks[col] > 1)
             {
                 allSinglyValidated = true;
-                minValue = DBL_MAX;
+                minValue = kForbiddenCost;
                 for(row=0; row<nOfRows; row++)
                 {
                     value = distMatrix[row + nOfRows*col];
-                    if(value!=DBL_MAX)
+                    if(value!=kForbiddenCost)
                     {
                         if(nOfValidObservations[row] > 1)
                         {
@@ -712,9 +758,9 @@ void AssignmentProblemSolver::assignmentsuboptimal1(int *assignment, double *cos
                     assignment[tmpRow] = col;
                     *cost += minValue;
                     for(n=0; n<nOfRows; n++)
-                        distMatrix[n + nOfRows*col] = DBL_MAX;
+                        distMatrix[n + nOfRows*col] = kForbiddenCost;
                     for(n=0; n<nOfColumns; n++)
-                        distMatrix[tmpRow + nOfRows*n] = DBL_MAX;
+                        distMatrix[tmpRow + nOfRows*n] = kForbiddenCost;
                 }
             }
         }	
@@ -725,12 +771,12 @@ void AssignmentProblemSolver::assignmentsuboptimal1(int *assignment, double *cos
     while(true)
     {
         /* find minimum distance observation-to-track pair */
-        minValue = DBL_MAX;
+        minValue = kForbiddenCost;
         for(row=0; row<nOfRows; row++)
             for(col=0; col<nOfColumns; col++)
             {
                 value = distMatrix[row + nOfRows*col];
-                if(value!=DBL_MAX && (value < minValue))
+                if(value!=kForbiddenCost && (value < minValue))
                 {
                     minValue = value;
                     tmpRow   = row;
@@ -738,14 +784,14 @@ void AssignmentProblemSolver::assignmentsuboptimal1(int *assignment, double *cos
                 }
             }
         
-        if(minValue!=DBL_MAX)
+        if(minValue!=kForbiddenCost)
         {
             assignment[tmpRow] = tmpCol;
             *cost += minValue;
             for(n=0; n<nOfRows; n++)
-                distMatrix[n + nOfRows*tmpCol] = DBL_MAX;
+                distMatrix[n + nOfRows*tmpCol] = kForbiddenCost;
             for(n=0; n<nOfColumns; n++)
-                distMatrix[tmpRow + nOfRows*n] = DBL_MAX;			
+                distMatrix[tmpRow + nOfRows*n] = kForbiddenCost;			
         }
         else
             break;
@@ -756,6 +802,601 @@ void AssignmentProblemSolver::assignmentsuboptimal1(int *assignment, double *cos
     free(nOfValidObservations);
     free(nOfValidTracks);
 }
+// --------------------------------------------------------------------------
+// Computes the optimal assignment with the shortest augmenting path method of
+// Jonker and Volgenant (LAPJV). Each free row is assigned by a Dijkstra-like
+// search over the reduced costs, after which the column prices are updated so
+// that the reduced costs stay non-negative. Rectangular problems are solved on
+// whichever of the matrix or its transpose has no more rows than columns, so
+// every row of that problem gets a column. Unlike the Munkres implementation,
+// this takes O(n^2 m) time in the worst case and only O(n + m) extra memory,
+// plus a row-major copy of the costs if the rows of that problem aren't
+// contiguous in the input.
+// --------------------------------------------------------------------------
+template <typename T>
+void AssignmentProblemSolver::assignmentjv(int *assignment, T *cost, const T *distMatrixIn, size_t rowStride, size_t colStride, int nOfRows, int nOfColumns, AssignmentWorkspace<T>& workspace)
+{
+    int n, m, i, j, row;
+    size_t stride;
+    bool transposed;
+    T minValue;
+    const T *c;
+    T *v;
+    int *rowSolution;
+    int *colSolution;
+    
+    *cost = 0;
+    for(row=0; row<nOfRows; row++)
+    {
+        assignment[row] = -1;
+    }
+    if(nOfRows == 0 || nOfColumns == 0)
+    {
+        return;
+    }
+    
+    // Solve with n <= m, on the transpose if there are more rows than columns.
+    transposed = nOfRows > nOfColumns;
+    n = transposed ? nOfColumns : nOfRows;
+    m = transposed ? nOfRows : nOfColumns;
+    c = rowmajorcosts(distMatrixIn, rowStride, colStride, nOfRows, nOfColumns, &stride, workspace);
+    
+    // Memory allocation (reusing the buffers from the last call if they're big enough)
+    workspace.jvPrices.assign(m, 0);
+    workspace.jvRowSolution.assign(n, -1);
+    workspace.jvColSolution.assign(m, -1);
+    v           = workspace.jvPrices.data();
+    rowSolution = workspace.jvRowSolution.data();
+    colSolution = workspace.jvColSolution.data();
+    
+    // For a square matrix, start from the column reduction: each column is priced at its
+    // smallest cost and given to that row if the row is still free. Columns that end up
+    // unassigned must keep a price of 0, so rectangular problems start from 0 instead.
+    if(n == m)
+    {
+        for(j=m-1; j>=0; j--)
+        {
+            row = 0;
+            minValue = c[j];
+            for(i=1; i<n; i++)
+            {
+                if(c[i*stride + j] < minValue)
+                {
+                    minValue = c[i*stride + j];
+                    row = i;
+                }
+            }
+            v[j] = minValue;
+            if(rowSolution[row] < 0)
+            {
+                rowSolution[row] = j;
+                colSolution[j] = row;
+            }
+        }
+    }
+    
+    augmentjv(c, stride, n, m, v, rowSolution, colSolution, workspace);
+    
+    // Form the result in terms of the original rows.
+    if(transposed)
+    {
+        for(i=0; i<n; i++)
+        {
+            assignment[rowSolution[i]] = i;
+        }
+    }
+    else
+    {
+        for(i=0; i<n; i++)
+        {
+            assignment[i] = rowSolution[i];
+        }
+    }
+    computeassignmentcost(assignment, cost, distMatrixIn, rowStride, colStride, nOfRows);
+}
+// --------------------------------------------------------------------------
+// Returns the row-major layout of whichever of the costs or their transpose
+// has no more rows than columns, and sets its row stride. Element (i, j) of
+// that problem is at distMatrixIn[i*iStride + j*jStride], so its rows are read
+// in place when jStride is 1 (a column-major input is the row-major layout of
+// its transpose), and copied into the workspace otherwise.
+// --------------------------------------------------------------------------
+template <typename T>
+const T *AssignmentProblemSolver::rowmajorcosts(const T *distMatrixIn, size_t rowStride, size_t colStride, int nOfRows, int nOfColumns, size_t *stride, AssignmentWorkspace<T>& workspace)
+{
+    int n, m, i, j;
+    size_t iStride, jStride;
+    bool transposed;
+    T *copy;
+    
+    transposed = nOfRows > nOfColumns;
+    n = transposed ? nOfColumns : nOfRows;
+    m = transposed ? nOfRows : nOfColumns;
+    iStride = transposed ? colStride : rowStride;
+    jStride = transposed ? rowStride : colStride;
+    if(jStride == 1)
+    {
+        *stride = iStride;
+        return distMatrixIn;
+    }
+    workspace.rowMajorCosts.resize(n*m);
+    copy = workspace.rowMajorCosts.data();
+    for(i=0; i<n; i++)
+    {
+        for(j=0; j<m; j++)
+        {
+            copy[i*m + j] = distMatrixIn[i*iStride + j*jStride];
+        }
+    }
+    *stride = m;
+    return copy;
+}
+// --------------------------------------------------------------------------
+// Assigns every free row of the n x m costs (n <= m), whose row i starts at
+// c + i*stride, by augmenting
+// along a shortest path, updating the column prices v and the row and column
+// solutions as it goes. Every assigned row must already be assigned to one of
+// the columns with the smallest reduced cost (cost minus price) in its row.
+// Returns the number of rows that were augmented.
+// --------------------------------------------------------------------------
+template <typename T>
+int AssignmentProblemSolver::augmentjv(const T *c, size_t stride, int n, int m, T *v, int *rowSolution, int *colSolution, AssignmentWorkspace<T>& workspace)
+{
+    int j, k, freeRow, row, endOfPath, low, up, last;
+    int numAugmented = 0;
+    bool unassignedFound;
+    T minValue, h, value;
+    T *d;
+    int *pred;
+    int *colList;
+    
+    // Memory allocation (reusing the buffers from the last call if they're big enough)
+    workspace.jvDistances.resize(m);
+    workspace.jvPred.resize(m);
+    workspace.jvColList.resize(m);
+    d           = workspace.jvDistances.data();
+    pred        = workspace.jvPred.data();
+    colList     = workspace.jvColList.data();
+    
+    for(freeRow=0; freeRow<n; freeRow++)
+    {
+        if(rowSolution[freeRow] >= 0)
+        {
+            continue;
+        }
+        numAugmented++;
+        
+        // The shortest path distances from freeRow to each column.
+        for(j=0; j<m; j++)
+        {
+            d[j] = c[freeRow*stride + j] - v[j];
+            pred[j] = freeRow;
+            colList[j] = j;
+        }
+        
+        // colList[0, low) are the columns that have been scanned, colList[low, up) are the
+        // columns at the current minimum distance waiting to be scanned, and colList[up, m)
+        // are the rest.
+        low = 0;
+        up = 0;
+        last = 0;
+        minValue = 0;
+        endOfPath = -1;
+        unassignedFound = false;
+        do
+        {
+            if(up == low)
+            {
+                // Collect the columns at the new minimum distance.
+                last = low - 1;
+                minValue = d[colList[up++]];
+                for(k=up; k<m; k++)
+                {
+                    j = colList[k];
+                    value = d[j];
+                    if(value <= minValue)
+                    {
+                        if(value < minValue)
+                        {
+                            up = low;
+                            minValue = value;
+                        }
+                        colList[k] = colList[up];
+                        colList[up++] = j;
+                    }
+                }
+                // Stop if one of them is unassigned.
+                for(k=low; k<up; k++)
+                {
+                    if(colSolution[colList[k]] < 0)
+                    {
+                        endOfPath = colList[k];
+                        unassignedFound = true;
+                        break;
+                    }
+                }
+            }
+            if(!unassignedFound)
+            {
+                // Scan the row assigned to the next column at the minimum distance.
+                j = colList[low++];
+                row = colSolution[j];
+                h = c[row*stride + j] - v[j] - minValue;
+                for(k=up; k<m; k++)
+                {
+                    j = colList[k];
+                    value = c[row*stride + j] - v[j] - h;
+                    if(value < d[j])
+                    {
+                        pred[j] = row;
+                        if(value == minValue)
+                        {
+                            if(colSolution[j] < 0)
+                            {
+                                endOfPath = j;
+                                unassignedFound = true;
+                                break;
+                            }
+                            colList[k] = colList[up];
+                            colList[up++] = j;
+                        }
+                        d[j] = value;
+                    }
+                }
+            }
+        }
+        while(!unassignedFound);
+        
+        // Update the prices of the scanned columns.
+        for(k=0; k<=last; k++)
+        {
+            j = colList[k];
+            v[j] += d[j] - minValue;
+        }
+        
+        // Augment along the path.
+        do
+        {
+            row = pred[endOfPath];
+            colSolution[endOfPath] = row;
+            j = endOfPath;
+            endOfPath = rowSolution[row];
+            rowSolution[row] = j;
+        }
+        while(row != freeRow);
+    }
+    return numAugmented;
+}
+// --------------------------------------------------------------------------
+// A round of auction bidding is split into stripes bid in parallel once the
+// bidders have at least this many costs to look at between them.
+// --------------------------------------------------------------------------
+static const long AUCTION_MIN_PARALLEL_COSTS = 1 << 15;
+// --------------------------------------------------------------------------
+// Each phase of epsilon scaling divides epsilon by this.
+// --------------------------------------------------------------------------
+static const int AUCTION_EPSILON_FACTOR = 5;
+// --------------------------------------------------------------------------
+// Computes the bids of bidders[start, end) in an auction on the n x n problem
+// whose first nOfCostRows rows are the row-major costs c, and whose other rows
+// cost nothing. Each bidder bids for the column worth the most to it (the one
+// with the least cost plus price), offering enough to make that column worth
+// as little as its second best column, plus epsilon.
+// --------------------------------------------------------------------------
+template <typename T>
+static void auctionbid(const T *c, size_t stride, int nOfCostRows, int n, const T *prices, T epsilon, const int *bidders, int start, int end, int *bidColumn, T *bid)
+{
+    int k, j, bestCol;
+    T value, bestValue, secondValue;
+    const T *row;
+    for(k=start; k<end; k++)
+    {
+        bestCol = 0;
+        bestValue = -numeric_limits<T>::infinity();
+        secondValue = -numeric_limits<T>::infinity();
+        if(bidders[k] < nOfCostRows)
+        {
+            row = c + bidders[k]*stride;
+            for(j=0; j<n; j++)
+            {
+                value = -row[j] - prices[j];
+                if(value > secondValue)
+                {
+                    if(value > bestValue)
+                    {
+                        secondValue = bestValue;
+                        bestValue = value;
+                        bestCol = j;
+                    }
+                    else
+                    {
+                        secondValue = value;
+                    }
+                }
+            }
+        }
+        else
+        {
+            for(j=0; j<n; j++)
+            {
+                value = -prices[j];
+                if(value > secondValue)
+                {
+                    if(value > bestValue)
+                    {
+                        secondValue = bestValue;
+                        bestValue = value;
+                        bestCol = j;
+                    }
+                    else
+                    {
+                        secondValue = value;
+                    }
+                }
+            }
+        }
+        bidColumn[k] = bestCol;
+        bid[k] = prices[bestCol] + (bestValue - secondValue) + epsilon;
+    }
+}
+// --------------------------------------------------------------------------
+// Bids for one stripe of the bidders on each thread.
+// --------------------------------------------------------------------------
+template <typename T>
+class AuctionBiddingBody : public cv::ParallelLoopBody
+{
+private:
+    const T *c;
+    size_t stride;
+    int nOfCostRows;
+    int n;
+    const T *prices;
+    T epsilon;
+    const int *bidders;
+    int nOfBidders;
+    int nOfStripes;
+    int *bidColumn;
+    T *bid;
+public:
+    AuctionBiddingBody(const T *c, size_t stride, int nOfCostRows, int n, const T *prices, T epsilon, const int *bidders, int nOfBidders, int nOfStripes, int *bidColumn, T *bid) :
+    c(c), stride(stride), nOfCostRows(nOfCostRows), n(n), prices(prices), epsilon(epsilon), bidders(bidders),
+    nOfBidders(nOfBidders), nOfStripes(nOfStripes), bidColumn(bidColumn), bid(bid)
+    {
+    }
+    
+    virtual void operator()(const cv::Range& range) const
+    {
+        for(int s=range.start; s<range.end; s++)
+        {
+            int start = (int)((long)nOfBidders*s/nOfStripes);
+            int end = (int)((long)nOfBidders*(s+1)/nOfStripes);
+            auctionbid(c, stride, nOfCostRows, n, prices, epsilon, bidders, start, end, bidColumn, bid);
+        }
+    }
+};
+// --------------------------------------------------------------------------
+// Computes a near optimal assignment with the auction algorithm of Bertsekas.
+// Each free row bids for the column that costs it the least after adding the
+// column's price, and each column goes to its highest bidder, freeing the row
+// it had before, at the price of the bid. All the free rows bid at once on the
+// same prices (Jacobi bidding), which lets them bid in parallel, and the bids
+// are settled in row order, so the result doesn't depend on the number of
+// threads. Every row ends up within epsilon of its best column, so the total
+// cost is within n * epsilon of optimal. Epsilon scaling starts with a large
+// epsilon that settles the prices roughly in a few rounds, and shrinks it to
+// the tolerance, keeping the prices from one phase to the next. Rectangular
+// problems are padded to a square with rows that cost nothing, because the
+// prices of columns left over would otherwise be wrong for the next phase.
+// --------------------------------------------------------------------------
+template <typename T>
+void AssignmentProblemSolver::assignmentauction(int *assignment, T *cost, const T *distMatrixIn, size_t rowStride, size_t colStride, int nOfRows, int nOfColumns, AssignmentWorkspace<T>& workspace)
+{
+    int n, m, i, j, k, row, owner, nOfBidders, nOfNextBidders, nOfStripes;
+    size_t stride;
+    bool transposed;
+    T minCost, maxCost, epsilon, tolerance;
+    const T *c;
+    T *prices;
+    int *rowSolution;
+    int *colSolution;
+    int *bidders;
+    int *nextBidders;
+    int *bidColumn;
+    T *bid;
+    T *bestBid;
+    int *bestBidder;
+    
+    *cost = 0;
+    for(row=0; row<nOfRows; row++)
+    {
+        assignment[row] = -1;
+    }
+    if(nOfRows == 0 || nOfColumns == 0)
+    {
+        return;
+    }
+    
+    // Solve with n <= m, on the transpose if there are more rows than columns.
+    transposed = nOfRows > nOfColumns;
+    n = transposed ? nOfColumns : nOfRows;
+    m = transposed ? nOfRows : nOfColumns;
+    c = rowmajorcosts(distMatrixIn, rowStride, colStride, nOfRows, nOfColumns, &stride, workspace);
+    
+    // Epsilon starts at a fraction of the range of the costs. It can't go below what the
+    // prices can resolve, or bids would stop raising them.
+    minCost = c[0];
+    maxCost = c[0];
+    for(i=0; i<n; i++)
+    {
+        for(j=0; j<m; j++)
+        {
+            minCost = min(minCost, c[i*stride + j]);
+            maxCost = max(maxCost, c[i*stride + j]);
+        }
+    }
+    tolerance = max((T)auctionTolerance, 64 * numeric_limits<T>::epsilon() * max(max(abs(minCost), abs(maxCost)), (T)1));
+    epsilon = max((maxCost - minCost) / AUCTION_EPSILON_FACTOR, tolerance);
+    
+    // Memory allocation (reusing the buffers from the last call if they're big enough)
+    workspace.auctionPrices.assign(m, 0);
+    workspace.auctionRowSolution.resize(m);
+    workspace.auctionColSolution.resize(m);
+    workspace.auctionBidders.resize(m);
+    workspace.auctionNextBidders.resize(m);
+    workspace.auctionBidColumn.resize(m);
+    workspace.auctionBid.resize(m);
+    workspace.auctionBestBid.resize(m);
+    workspace.auctionBestBidder.assign(m, -1);
+    prices      = workspace.auctionPrices.data();
+    rowSolution = workspace.auctionRowSolution.data();
+    colSolution = workspace.auctionColSolution.data();
+    bidders     = workspace.auctionBidders.data();
+    nextBidders = workspace.auctionNextBidders.data();
+    bidColumn   = workspace.auctionBidColumn.data();
+    bid         = workspace.auctionBid.data();
+    bestBid     = workspace.auctionBestBid.data();
+    bestBidder  = workspace.auctionBestBidder.data();
+    
+    if(m == 1)
+    {
+        rowSolution[0] = 0;
+    }
+    else while(true)
+    {
+        // Each phase starts with every row free.
+        for(k=0; k<m; k++)
+        {
+            rowSolution[k] = -1;
+            colSolution[k] = -1;
+            bidders[k] = k;
+        }
+        nOfBidders = m;
+        while(nOfBidders > 0)
+        {
+            // Bid, in parallel if there's enough to look at.
+            nOfStripes = (int)min((long)cv::getNumThreads(), (long)nOfBidders*m / AUCTION_MIN_PARALLEL_COSTS);
+            if(nOfStripes > 1)
+            {
+                cv::parallel_for_(cv::Range(0, nOfStripes), AuctionBiddingBody<T>(c, stride, n, m, prices, epsilon, bidders, nOfBidders, nOfStripes, bidColumn, bid));
+            }
+            else
+            {
+                auctionbid(c, stride, n, m, prices, epsilon, bidders, 0, nOfBidders, bidColumn, bid);
+            }
+            
+            // Find the highest bid for each column (the first one, if there's a tie).
+            for(k=0; k<nOfBidders; k++)
+            {
+                j = bidColumn[k];
+                if(bestBidder[j] < 0 || bid[k] > bestBid[j])
+                {
+                    bestBidder[j] = bidders[k];
+                    bestBid[j] = bid[k];
+                }
+            }
+            
+            // Give each column to its highest bidder, freeing the row it had. Everyone
+            // else bids again.
+            nOfNextBidders = 0;
+            for(k=0; k<nOfBidders; k++)
+            {
+                row = bidders[k];
+                j = bidColumn[k];
+                if(bestBidder[j] != row)
+                {
+                    nextBidders[nOfNextBidders++] = row;
+                    continue;
+                }
+                owner = colSolution[j];
+                if(owner >= 0)
+                {
+                    rowSolution[owner] = -1;
+                    nextBidders[nOfNextBidders++] = owner;
+                }
+                colSolution[j] = row;
+                rowSolution[row] = j;
+                prices[j] = bestBid[j];
+                bestBidder[j] = -1;
+            }
+            swap(bidders, nextBidders);
+            nOfBidders = nOfNextBidders;
+        }
+        
+        if(epsilon <= tolerance)
+        {
+            break;
+        }
+        epsilon = max(epsilon / AUCTION_EPSILON_FACTOR, tolerance);
+    }
+    
+    // Form the result in terms of the original rows, leaving out the padding.
+    for(i=0; i<n; i++)
+    {
+        if(transposed)
+        {
+            assignment[rowSolution[i]] = i;
+        }
+        else
+        {
+            assignment[i] = rowSolution[i];
+        }
+    }
+    computeassignmentcost(assignment, cost, distMatrixIn, rowStride, colStride, nOfRows);
+}
+// --------------------------------------------------------------------------
+// Drops the starting matches that aren't among their row's cheapest columns
+// at the starting prices (or whose column was already taken), then assigns
+// the rows left free by Jonker-Volgenant augmentation. All the scratch memory
+// comes from Workspace.
+// --------------------------------------------------------------------------
+int AssignmentProblemSolver::SolveWarm(const double *Costs, int N, vector<double>& ColumnPrices, vector<int>& Assignment, AssignmentWorkspace<double>& Workspace)
+{
+    int i, j, k;
+    double reducedCost;
+    int *rowSolution;
+    int *colSolution;
+    
+    ColumnPrices.resize(N);
+    Assignment.resize(N, -1);
+    Workspace.jvColSolution.assign(N, -1);
+    rowSolution = Assignment.data();
+    colSolution = Workspace.jvColSolution.data();
+    
+    // Keep a row's starting column only if no other row has already taken it, and no other
+    // column is cheaper for the row at the starting prices.
+    for(i=0; i<N; i++)
+    {
+        j = rowSolution[i];
+        if(j < 0)
+        {
+            continue;
+        }
+        if(j >= N || colSolution[j] >= 0)
+        {
+            rowSolution[i] = -1;
+            continue;
+        }
+        reducedCost = Costs[i*N + j] - ColumnPrices[j];
+        for(k=0; k<N; k++)
+        {
+            if(Costs[i*N + k] - ColumnPrices[k] < reducedCost)
+            {
+                break;
+            }
+        }
+        if(k < N)
+        {
+            rowSolution[i] = -1;
+            continue;
+        }
+        colSolution[j] = i;
+    }
+    
+    return augmentjv(Costs, N, N, N, ColumnPrices.data(), rowSolution, colSolution, Workspace);
+}
+
+template float AssignmentProblemSolver::Solve<float>(const float *Costs,int nOfRows,int nOfColumns,size_t RowStride,vector<int>& Assignment,AssignmentWorkspace<float>& Workspace,TMethod Method);
+template double AssignmentProblemSolver::Solve<double>(const double *Costs,int nOfRows,int nOfColumns,size_t RowStride,vector<int>& Assignment,AssignmentWorkspace<double>& Workspace,TMethod Method);
 /*
  // --------------------------------------------------------------------------
  // Usage example
@@ -1,7 +1,10 @@
 #include "modes/tracking_mode.hpp"
+#include "modes/pipelined_tracking_mode.hpp"
 #include "modes/plotting_mode.hpp"
 #include "modes/ground_truth_mode.hpp"
+#include "modes/benchmark_mode.hpp"
 
+#include <iostream>
 #include <string>
 
 #include "lib/cmdparser.hpp"
@@ -9,30 +12,58 @@
 int main(int argc, char **argv) {
     // Parse the command line arguments.
     cli::Parser parser(argc, argv);
-    parser.set_required<std::string>("m", "The mode that the tracker should be run in: either tracker, plotter, ground_truth");
+    parser.set_required<std::string>("m", "The mode that the tracker should be run in: either tracker, plotter, ground_truth, benchmark");
     
     // Arguments common to all modes.
-    parser.set_required<std::string>("i", "input video");
+    parser.set_optional<std::string>("i", "input", "", "The input video. Required except with a webcam (-w) and for the synthetic benchmarks (assignment, association, partitioned, parallel), which ignore it.");
     parser.set_optional<std::vector<int>>("p", "perspective_points", std::vector<int>(), "The perspective points");
     parser.set_optional<int>("d", "max_dimension", -1, "Scale the video so that the # rows and # cols do not exceed this value. Preserve the aspect ratio.");
+    parser.set_optional<bool>("hl", "headless", false, "Run without creating any windows, drawing anything, or polling the keyboard.");
     parser.set_optional<std::string>("s", "support_file", "", "Path to the support file. If you're in tracker mode, this is the output JSON file for the tracker. If you're in plotter mode, this is the path to the tracks file, which is a (timestamp, x, y, frame) CSV");
     
     // Arguments for tracker mode.
     parser.set_optional<int>("w", "webcam", -1, "number to use (this will override -i)");
+    parser.set_optional<bool>("wd", "warp_detections", false, "Apply the perspective transform to the detected objects instead of to every frame.");
+    parser.set_optional<bool>("lu", "luma", false, "Find objects in grayscale frames instead of color frames.");
+    parser.set_optional<bool>("cc", "connected_components", false, "Find objects with connected component labeling instead of contours.");
+    parser.set_optional<std::string>("as", "association", "dense", "How to associate trackers with objects: dense, gated, incremental, or auction.");
+    parser.set_optional<bool>("ca", "cascade", false, "Match the trackers alone in an object's bounding box (or clearly the oldest in it) before associating the rest.");
+    parser.set_optional<int>("pt", "parallel_trackers", 0, "Update the trackers in parallel once there are at least this many of them (0 to always update them serially).");
+    parser.set_optional<std::vector<int>>("zg", "zone_grid", std::vector<int>(), "Split the frame into this many columns and rows of zones that are tracked in parallel, handing the trackers over as objects cross between them.");
+    parser.set_optional<bool>("pl", "pipelined", false, "Run decoding, preprocessing, detection, and tracking on separate threads.");
+    parser.set_optional<int>("qs", "queue_size", 4, "In pipelined mode, the number of frames that can wait between two stages.");
     
     // Arguments for plotter mode.
     parser.set_optional<std::string>("s2", "track_file_2", "", "The second track file for the plotter");
     
+    // Arguments for benchmark mode.
+    parser.set_optional<std::string>("b", "benchmark", "luma", "The benchmark to run: luma, tracking, assignment, association, partitioned, parallel");
+    parser.set_optional<int>("bn", "benchmark_frames", -1, "The maximum number of frames to benchmark on (-1 for all of them).");
+    
     parser.run_and_exit_if_error();
     
     auto mode = parser.get<std::string>("m");
     
-    if (mode == "tracker") {
+    // Every mode reads the input video, except the tracker on a webcam and the synthetic benchmarks.
+    auto benchmark = parser.get<std::string>("b");
+    bool isSynthetic = mode == "benchmark" && (benchmark == "assignment" || benchmark == "association"
+                                               || benchmark == "partitioned" || benchmark == "parallel");
+    bool usesWebcam = mode == "tracker" && parser.get<int>("w") != -1;
+    if (parser.get<std::string>("i").empty() && !isSynthetic && !usesWebcam) {
+        std::cerr << "An input video (-i) is required in this mode" << std::endl;
+        return 1;
+    }
+    
+    if (mode == "tracker" && parser.get<bool>("pl")) {
+        OT::Mode::PipelinedTracking::run(parser);
+    } else if (mode == "tracker") {
         OT::Mode::Tracking::run(parser);
     } else if (mode == "plotter") {
         OT::Mode::Plotting::run(parser);
     } else if (mode == "ground_truth") {
         OT::Mode::GroundTruth::run(parser);
+    } else if (mode == "benchmark") {
+        return OT::Mode::Benchmark::run(parser);
     }
     return 0;
 }
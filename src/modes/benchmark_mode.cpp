@@ -0,0 +1,627 @@
+#include "modes/benchmark_mode.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <algorithm>
+
+#include <opencv2/opencv.hpp>
+
+#include "tracker/contour_finder.hpp"
+#include "tracker/multi_object_tracker.hpp"
+#include "tracker/partitioned_tracker.hpp"
+#include "lib/hungarian.hpp"
+#include "lib/cmdparser.hpp"
+#include "utils/allocation_counter.hpp"
+#include "utils/frame_transformer.hpp"
+
+namespace OT {
+    namespace Mode {
+        namespace Benchmark {
+            typedef std::chrono::steady_clock Clock;
+            
+            // The result of running detection over a video.
+            struct DetectionRun {
+                // The time spent transforming frames and finding contours (not decoding).
+                double seconds;
+                
+                // The number of objects found in each frame.
+                std::vector<size_t> detectionsPerFrame;
+                
+                // The number of frames after the first during which the contour finder's own buffers grew.
+                long bufferGrowths;
+            };
+            
+            // Run the frame transform and contour finder on (at most maxFrames frames of) the input video.
+            DetectionRun runDetection(const cli::Parser& parser, bool luma, long maxFrames) {
+                DetectionRun result{0, std::vector<size_t>(), 0};
+                
+                cv::VideoCapture capture;
+                capture.open(parser.get<std::string>("i"));
+                if(!capture.isOpened()) {
+                    std::cerr << "Problem opening video source" << std::endl;
+                    return result;
+                }
+                
+                OT::FrameTransformer frameTransformer(parser.get<std::vector<int>>("p"),
+                                                      parser.get<int>("d"),
+                                                      parser.get<bool>("wd"),
+                                                      luma);
+                OT::ContourFinder contourFinder;
+                contourFinder.setHeadless(true);
+                contourFinder.setConnectedComponents(parser.get<bool>("cc"));
+                
+                cv::Mat rawFrame;
+                cv::Mat frame;
+                std::vector<cv::Vec4i> hierarchy;
+                std::vector<std::vector<cv::Point>> contours;
+                std::vector<cv::Point2f> massCenters;
+                std::vector<cv::Rect> boundingBoxes;
+                while ((maxFrames < 0 || (long) result.detectionsPerFrame.size() < maxFrames)
+                       && capture.read(rawFrame)) {
+                    auto start = Clock::now();
+                    frameTransformer.transform(rawFrame, frame);
+                    contourFinder.findContours(frame, hierarchy, contours, massCenters, boundingBoxes);
+                    result.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+                    result.detectionsPerFrame.push_back(massCenters.size());
+                }
+                result.bufferGrowths = contourFinder.bufferGrowths();
+                return result;
+            }
+            
+            void printDetectionRun(const std::string& name, const DetectionRun& run) {
+                size_t numDetections = 0;
+                for (auto count : run.detectionsPerFrame) {
+                    numDetections += count;
+                }
+                size_t numFrames = run.detectionsPerFrame.size();
+                std::cout << "  " << std::left << std::setw(6) << name
+                          << std::right << std::fixed
+                          << std::setw(10) << std::setprecision(2) << (run.seconds > 0 ? numFrames / run.seconds : 0)
+                          << std::setw(12) << numDetections
+                          << std::setw(12) << std::setprecision(3) << (numFrames > 0 ? (1.0 * numDetections) / numFrames : 0)
+                          << std::setw(16) << run.bufferGrowths
+                          << std::endl;
+            }
+            
+            void benchmarkLuma(const cli::Parser& parser) {
+                long maxFrames = parser.get<int>("bn");
+                DetectionRun bgr = runDetection(parser, false, maxFrames);
+                DetectionRun luma = runDetection(parser, true, maxFrames);
+                
+                // Count the frames where the two paths disagree on the number of objects.
+                size_t numFrames = std::min(bgr.detectionsPerFrame.size(), luma.detectionsPerFrame.size());
+                size_t numDiffering = 0;
+                for (size_t i = 0; i < numFrames; i++) {
+                    if (bgr.detectionsPerFrame[i] != luma.detectionsPerFrame[i]) {
+                        numDiffering++;
+                    }
+                }
+                
+                std::cout << "Detection on " << numFrames << " frames of " << parser.get<std::string>("i") << std::endl;
+                std::cout << "  " << std::left << std::setw(6) << "path"
+                          << std::right
+                          << std::setw(10) << "FPS"
+                          << std::setw(12) << "detections"
+                          << std::setw(12) << "per frame"
+                          << std::setw(16) << "buffer growths" << std::endl;
+                printDetectionRun("bgr", bgr);
+                printDetectionRun("luma", luma);
+                std::cout << "  Frames with different detection counts: " << numDiffering << std::endl;
+            }
+            
+            // The objects found in one frame, and for synthetic sequences, where each object really is.
+            struct FrameDetections {
+                std::vector<cv::Point2f> massCenters;
+                std::vector<cv::Rect> boundingBoxes;
+                std::vector<cv::Point2f> objects;
+            };
+            
+            // Find the objects in (at most maxFrames frames of) the input video, in the coordinates
+            // they are tracked in. trackingSize is set to the size of that space.
+            std::vector<FrameDetections> collectDetections(const cli::Parser& parser, long maxFrames, cv::Size& trackingSize) {
+                std::vector<FrameDetections> detections;
+                
+                cv::VideoCapture capture;
+                capture.open(parser.get<std::string>("i"));
+                if(!capture.isOpened()) {
+                    std::cerr << "Problem opening video source" << std::endl;
+                    return detections;
+                }
+                
+                OT::FrameTransformer frameTransformer(parser.get<std::vector<int>>("p"),
+                                                      parser.get<int>("d"),
+                                                      parser.get<bool>("wd"),
+                                                      parser.get<bool>("lu"));
+                OT::ContourFinder contourFinder;
+                contourFinder.setHeadless(true);
+                contourFinder.setConnectedComponents(parser.get<bool>("cc"));
+                
+                cv::Mat rawFrame;
+                cv::Mat frame;
+                std::vector<cv::Vec4i> hierarchy;
+                std::vector<std::vector<cv::Point>> contours;
+                while ((maxFrames < 0 || (long) detections.size() < maxFrames) && capture.read(rawFrame)) {
+                    FrameDetections frameDetections;
+                    frameTransformer.transform(rawFrame, frame);
+                    contourFinder.findContours(frame, hierarchy, contours,
+                                               frameDetections.massCenters, frameDetections.boundingBoxes);
+                    frameTransformer.transformDetections(frameDetections.massCenters, frameDetections.boundingBoxes);
+                    trackingSize = frameTransformer.detectionSize(frame.size());
+                    detections.push_back(std::move(frameDetections));
+                }
+                return detections;
+            }
+            
+            // Returns false if a frame allocated without the tracker or its outputs having to grow
+            // (which is only checked in the benchmark executable, which counts allocations).
+            bool benchmarkTracking(const cli::Parser& parser) {
+                cv::Size trackingSize;
+                std::vector<FrameDetections> detections = collectDetections(parser, parser.get<int>("bn"), trackingSize);
+                
+                // Only the tracker's updates are timed.
+                OT::MultiObjectTracker tracker(cv::Size(trackingSize.height, trackingSize.width));
+                if (!tracker.setAssociation(parser.get<std::string>("as"))) {
+                    std::cerr << "Unknown association: " << parser.get<std::string>("as") << std::endl;
+                    return false;
+                }
+                tracker.setCascade(parser.get<bool>("ca"));
+                tracker.setMinParallelTrackers(parser.get<int>("pt"));
+                std::vector<OT::TrackingOutput> outputs;
+                size_t numOutputs = 0;
+                
+                // The first frame and the frames where the tracker or its outputs grew are
+                // warming up, and may allocate. Every other frame is in a steady state, and
+                // must not.
+                long numAllocatingFrames = 0;
+                double seconds = 0;
+                for (size_t f = 0; f < detections.size(); f++) {
+                    long growths = tracker.scratchGrowths();
+                    size_t outputCapacity = outputs.capacity();
+                    long allocations = OT::AllocationCounter::count();
+                    auto start = Clock::now();
+                    tracker.update(detections[f].massCenters, detections[f].boundingBoxes, outputs);
+                    seconds += std::chrono::duration<double>(Clock::now() - start).count();
+                    bool isWarmingUp = f == 0 || tracker.scratchGrowths() > growths || outputs.capacity() > outputCapacity;
+                    if (!isWarmingUp && OT::AllocationCounter::count() > allocations) {
+                        numAllocatingFrames++;
+                    }
+                    numOutputs += outputs.size();
+                }
+                
+                std::cout << "Tracking on " << detections.size() << " frames of " << parser.get<std::string>("i") << std::endl;
+                std::cout << "  " << std::left << std::setw(16) << "updates per sec"
+                          << std::right << std::fixed << std::setprecision(2)
+                          << std::setw(12) << (seconds > 0 ? detections.size() / seconds : 0) << std::endl;
+                std::cout << "  " << std::left << std::setw(16) << "association ms"
+                          << std::right << std::setw(12) << (detections.empty() ? 0 : 1000 * tracker.associationTime() / detections.size()) << std::endl;
+                std::cout << "  " << std::left << std::setw(16) << "outputs"
+                          << std::right << std::setw(12) << numOutputs << std::endl;
+                std::cout << "  " << std::left << std::setw(16) << "buffer growths"
+                          << std::right << std::setw(12) << tracker.scratchGrowths() << std::endl;
+                if (OT::AllocationCounter::isCounting()) {
+                    std::cout << "  " << std::left << std::setw(16) << "allocating"
+                              << std::right << std::setw(12) << numAllocatingFrames
+                              << "  (frames that allocated on any thread)" << std::endl;
+                } else {
+                    std::cout << "  Allocations aren't counted; run the benchmark executable to check them" << std::endl;
+                }
+                if (numAllocatingFrames > 0) {
+                    std::cerr << numAllocatingFrames << " steady-state frames allocated in update" << std::endl;
+                    return false;
+                }
+                return true;
+            }
+            
+            // A synthetic association problem between numTracks predictions scattered over a unit
+            // square and the detections of the same objects, slightly moved. Costs are distances
+            // normalized by the diagonal, like the multi-object tracker's.
+            std::vector<std::vector<double>> makeAssignmentProblem(int numTracks, int numDetections, cv::RNG& rng) {
+                std::vector<cv::Point2d> tracks(numTracks);
+                for (auto& track : tracks) {
+                    track = cv::Point2d(rng.uniform(0.0, 1.0), rng.uniform(0.0, 1.0));
+                }
+                std::vector<cv::Point2d> detections(numDetections);
+                for (int j = 0; j < numDetections; j++) {
+                    if (j < numTracks) {
+                        detections[j] = tracks[j] + cv::Point2d(rng.gaussian(0.01), rng.gaussian(0.01));
+                    } else {
+                        detections[j] = cv::Point2d(rng.uniform(0.0, 1.0), rng.uniform(0.0, 1.0));
+                    }
+                }
+                std::vector<std::vector<double>> costs(numTracks, std::vector<double>(numDetections));
+                for (int i = 0; i < numTracks; i++) {
+                    for (int j = 0; j < numDetections; j++) {
+                        costs[i][j] = cv::norm(tracks[i] - detections[j]) / std::sqrt(2.0);
+                    }
+                }
+                return costs;
+            }
+            
+            // A way of solving the benchmark problem, which returns the cost of its assignment.
+            // That cost may be up to n times tolerance more than the optimum.
+            struct AssignmentMethod {
+                std::string name;
+                double tolerance;
+                std::function<double()> solve;
+            };
+            
+            // The result of solving the same problem repeatedly with one method.
+            struct AssignmentRun {
+                // The mean time per solve, or a negative number if the method was skipped.
+                double milliseconds;
+                
+                // The total cost of the assignment.
+                double cost;
+            };
+            
+            // Solve the problem until at least minSeconds have passed (at least once). solve
+            // returns the cost of the assignment.
+            AssignmentRun runAssignment(const std::function<double()>& solve, double minSeconds) {
+                AssignmentRun result{0, 0};
+                long numSolves = 0;
+                double seconds = 0;
+                while (numSolves == 0 || seconds < minSeconds) {
+                    auto start = Clock::now();
+                    result.cost = solve();
+                    seconds += std::chrono::duration<double>(Clock::now() - start).count();
+                    numSolves++;
+                }
+                result.milliseconds = 1000 * seconds / numSolves;
+                return result;
+            }
+            
+            void benchmarkAssignment(const cli::Parser& parser) {
+                // Once a method takes longer than this for one solve, it is skipped for bigger problems.
+                const double maxSeconds = 1;
+                
+                const std::vector<int> sizes = {10, 20, 50, 100, 200, 500, 1000, 2000};
+                
+                // The nested vector problems are copied by the solver, and the row-major ones
+                // are solved in place with a workspace that we own.
+                cv::RNG rng(12345);
+                AssignmentProblemSolver solver;
+                AssignmentWorkspace<double> workspace;
+                AssignmentWorkspace<float> floatWorkspace;
+                std::vector<int> assignment;
+                std::vector<std::vector<double>> costs;
+                std::vector<double> rowMajorCosts;
+                std::vector<float> floatCosts;
+                int n = 0;
+                auto solveAuction = [&](double tolerance) {
+                    solver.SetAuctionTolerance(tolerance);
+                    return solver.Solve(rowMajorCosts.data(), n, n, n, assignment, workspace,
+                                        AssignmentProblemSolver::auction);
+                };
+                const std::vector<AssignmentMethod> methods = {
+                    {"munkres", 0, [&]() {
+                        return solver.Solve(costs, assignment, AssignmentProblemSolver::optimal);
+                    }},
+                    {"lapjv", 0, [&]() {
+                        return solver.Solve(costs, assignment, AssignmentProblemSolver::jonker_volgenant);
+                    }},
+                    {"lapjv rowmajor", 0, [&]() {
+                        return solver.Solve(rowMajorCosts.data(), n, n, n, assignment, workspace,
+                                            AssignmentProblemSolver::jonker_volgenant);
+                    }},
+                    {"lapjv float", 0, [&]() {
+                        return (double) solver.Solve(floatCosts.data(), n, n, n, assignment, floatWorkspace,
+                                                     AssignmentProblemSolver::jonker_volgenant);
+                    }},
+                    {"auction 1e-6", 1e-6, [&]() { return solveAuction(1e-6); }},
+                    {"auction 1e-3", 1e-3, [&]() { return solveAuction(1e-3); }}
+                };
+                
+                std::cout << "Assignment on synthetic n x n problems (ms per solve)" << std::endl;
+                std::cout << "  " << std::left << std::setw(8) << "n" << std::right;
+                for (const auto& method : methods) {
+                    std::cout << std::setw(16) << method.name;
+                }
+                std::cout << std::setw(16) << "same cost" << std::endl;
+                
+                std::vector<bool> skipped(methods.size(), false);
+                for (int size : sizes) {
+                    n = size;
+                    costs = makeAssignmentProblem(n, n, rng);
+                    rowMajorCosts.resize(n * n);
+                    floatCosts.resize(n * n);
+                    for (int i = 0; i < n; i++) {
+                        for (int j = 0; j < n; j++) {
+                            rowMajorCosts[i * n + j] = costs[i][j];
+                            floatCosts[i * n + j] = (float) costs[i][j];
+                        }
+                    }
+                    
+                    std::vector<AssignmentRun> runs;
+                    for (size_t k = 0; k < methods.size(); k++) {
+                        if (skipped[k]) {
+                            runs.push_back(AssignmentRun{-1, 0});
+                            continue;
+                        }
+                        runs.push_back(runAssignment(methods[k].solve, 0.2));
+                        skipped[k] = runs.back().milliseconds > 1000 * maxSeconds;
+                    }
+                    
+                    // Compare the costs of the methods that ran with the first one that did, to
+                    // float precision or the method's tolerance.
+                    bool sameCost = true;
+                    const AssignmentRun* reference = nullptr;
+                    std::cout << "  " << std::left << std::setw(8) << n << std::right << std::fixed << std::setprecision(3);
+                    for (size_t k = 0; k < runs.size(); k++) {
+                        const AssignmentRun& run = runs[k];
+                        if (run.milliseconds < 0) {
+                            std::cout << std::setw(16) << "-";
+                            continue;
+                        }
+                        std::cout << std::setw(16) << run.milliseconds;
+                        if (reference == nullptr) {
+                            reference = &run;
+                        } else if (std::abs(run.cost - reference->cost) > std::max(1e-4 * std::max(1.0, reference->cost),
+                                                                                  n * methods[k].tolerance)) {
+                            sameCost = false;
+                        }
+                    }
+                    std::cout << std::setw(16) << (sameCost ? "yes" : "no") << std::endl;
+                }
+            }
+            
+            // A synthetic sequence with numObjects objects moving around a scene of the given size
+            // and bouncing off its edges. Each object is missed in 5% of the frames, and there are
+            // a few spurious detections in every frame.
+            std::vector<FrameDetections> makeCrowdedSequence(int numObjects, int numFrames, cv::Size size, cv::RNG& rng) {
+                std::vector<cv::Point2f> positions(numObjects);
+                std::vector<cv::Point2f> velocities(numObjects);
+                for (int k = 0; k < numObjects; k++) {
+                    positions[k] = cv::Point2f(rng.uniform(0.0f, (float) size.width), rng.uniform(0.0f, (float) size.height));
+                    velocities[k] = cv::Point2f(rng.gaussian(2), rng.gaussian(2));
+                }
+                
+                std::vector<FrameDetections> sequence(numFrames);
+                for (auto& frame : sequence) {
+                    for (int k = 0; k < numObjects; k++) {
+                        cv::Point2f& position = positions[k];
+                        cv::Point2f& velocity = velocities[k];
+                        position += velocity;
+                        if (position.x < 0 || position.x >= size.width) {
+                            velocity.x = -velocity.x;
+                            position.x = std::min(std::max(position.x, 0.0f), size.width - 1.0f);
+                        }
+                        if (position.y < 0 || position.y >= size.height) {
+                            velocity.y = -velocity.y;
+                            position.y = std::min(std::max(position.y, 0.0f), size.height - 1.0f);
+                        }
+                        frame.objects.push_back(position);
+                        if (rng.uniform(0.0, 1.0) >= 0.05) {
+                            frame.massCenters.push_back(position + cv::Point2f(rng.gaussian(1), rng.gaussian(1)));
+                        }
+                    }
+                    for (int k = 0; k < 3; k++) {
+                        frame.massCenters.push_back(cv::Point2f(rng.uniform(0.0f, (float) size.width), rng.uniform(0.0f, (float) size.height)));
+                    }
+                    for (const auto& massCenter : frame.massCenters) {
+                        frame.boundingBoxes.push_back(cv::Rect((int) massCenter.x - 4, (int) massCenter.y - 4, 8, 8));
+                    }
+                }
+                return sequence;
+            }
+            
+            void benchmarkAssociation(const cli::Parser& parser) {
+                const int numFrames = 500;
+                const cv::Size size(800, 600);
+                const std::vector<int> objectCounts = {25, 50, 100, 200};
+                const std::vector<std::string> associations = {"dense", "gated", "incremental", "auction"};
+                
+                std::cout << "Association on synthetic " << numFrames << " frame sequences in a "
+                          << size.width << " x " << size.height << " scene (ms per frame)" << std::endl;
+                std::cout << "  " << std::left << std::setw(10) << "objects" << std::setw(22) << "association"
+                          << std::right << std::setw(14) << "associate" << std::setw(14) << "update"
+                          << std::setw(14) << "augmented" << std::endl;
+                
+                cv::RNG rng(12345);
+                for (int numObjects : objectCounts) {
+                    auto sequence = makeCrowdedSequence(numObjects, numFrames, size, rng);
+                    for (const auto& association : associations) {
+                        for (bool cascade : {false, true}) {
+                            OT::MultiObjectTracker tracker(cv::Size(size.height, size.width));
+                            tracker.setAssociation(association);
+                            tracker.setCascade(cascade);
+                            std::vector<OT::TrackingOutput> outputs;
+                            auto start = Clock::now();
+                            for (const auto& frame : sequence) {
+                                tracker.update(frame.massCenters, frame.boundingBoxes, outputs);
+                            }
+                            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+                            
+                            std::cout << "  " << std::left << std::setw(10) << numObjects
+                                      << std::setw(22) << (cascade ? association + " + cascade" : association)
+                                      << std::right << std::fixed << std::setprecision(3)
+                                      << std::setw(14) << 1000 * tracker.associationTime() / numFrames
+                                      << std::setw(14) << 1000 * seconds / numFrames;
+                            if (association == "incremental") {
+                                std::cout << std::setw(14) << std::setprecision(2) << (1.0 * tracker.augmentedRows()) / numFrames;
+                            }
+                            std::cout << std::endl;
+                        }
+                    }
+                }
+                std::cout << "  (augmented is the number of trackers per frame that incremental association had to reassign)" << std::endl;
+            }
+            
+            // Track the synthetic sequence, returning the seconds spent in update, counting the
+            // distinct IDs that were reported, averaging the number of outputs per frame, and
+            // counting the times an object's ID changed. An object has the ID of the closest
+            // output within a few pixels of it, if there is one.
+            template <typename Tracker>
+            double trackSequence(Tracker& tracker, const std::vector<FrameDetections>& sequence,
+                                 size_t& numIds, double& tracksPerFrame, long& numSwitches) {
+                const double matchDistance = 8;
+                std::vector<OT::TrackingOutput> outputs;
+                std::vector<int> ids;
+                std::vector<int> objectIds(sequence.empty() ? 0 : sequence[0].objects.size(), -1);
+                double seconds = 0;
+                numSwitches = 0;
+                for (const auto& frame : sequence) {
+                    auto start = Clock::now();
+                    tracker.update(frame.massCenters, frame.boundingBoxes, outputs);
+                    seconds += std::chrono::duration<double>(Clock::now() - start).count();
+                    for (const auto& output : outputs) {
+                        ids.push_back(output.id);
+                    }
+                    for (size_t k = 0; k < frame.objects.size(); k++) {
+                        double closestDistance = matchDistance;
+                        int id = -1;
+                        for (const auto& output : outputs) {
+                            double distance = cv::norm(cv::Point2f(output.location) - frame.objects[k]);
+                            if (distance <= closestDistance) {
+                                closestDistance = distance;
+                                id = output.id;
+                            }
+                        }
+                        if (id != -1) {
+                            numSwitches += objectIds[k] != -1 && objectIds[k] != id;
+                            objectIds[k] = id;
+                        }
+                    }
+                }
+                std::sort(ids.begin(), ids.end());
+                tracksPerFrame = (double) ids.size() / sequence.size();
+                numIds = std::unique(ids.begin(), ids.end()) - ids.begin();
+                return seconds;
+            }
+            
+            void benchmarkPartitioned(const cli::Parser& parser) {
+                const int numFrames = 300;
+                const cv::Size size(3200, 2400);
+                const int overlap = 64;
+                const std::vector<int> objectCounts = {100, 200, 400};
+                const std::vector<cv::Size> zoneGrids = {cv::Size(1, 1), cv::Size(2, 2), cv::Size(4, 4)};
+                
+                std::cout << "Partitioned tracking on synthetic " << numFrames << " frame sequences in a "
+                          << size.width << " x " << size.height << " scene with " << overlap
+                          << " pixel bands (ms per frame, " << parser.get<std::string>("as") << " association)" << std::endl;
+                std::cout << "  " << std::left << std::setw(10) << "objects" << std::setw(10) << "zones"
+                          << std::right << std::setw(14) << "associate" << std::setw(14) << "update"
+                          << std::setw(14) << "tracks" << std::setw(14) << "IDs" << std::setw(14) << "switches" << std::endl;
+                
+                cv::RNG rng(12345);
+                for (int numObjects : objectCounts) {
+                    auto sequence = makeCrowdedSequence(numObjects, numFrames, size, rng);
+                    
+                    // One MultiObjectTracker for the whole frame, then the zone grids.
+                    for (int g = -1; g < (int) zoneGrids.size(); g++) {
+                        double seconds;
+                        double associationSeconds;
+                        size_t numIds;
+                        double tracksPerFrame;
+                        long numSwitches;
+                        std::string zones = "none";
+                        if (g == -1) {
+                            OT::MultiObjectTracker tracker(cv::Size(size.height, size.width));
+                            tracker.setAssociation(parser.get<std::string>("as"));
+                            tracker.setCascade(parser.get<bool>("ca"));
+                            seconds = trackSequence(tracker, sequence, numIds, tracksPerFrame, numSwitches);
+                            associationSeconds = tracker.associationTime();
+                        } else {
+                            OT::PartitionedTracker tracker(size, zoneGrids[g].width, zoneGrids[g].height, overlap);
+                            tracker.setAssociation(parser.get<std::string>("as"));
+                            tracker.setCascade(parser.get<bool>("ca"));
+                            seconds = trackSequence(tracker, sequence, numIds, tracksPerFrame, numSwitches);
+                            associationSeconds = tracker.associationTime();
+                            zones = std::to_string(zoneGrids[g].width) + " x " + std::to_string(zoneGrids[g].height);
+                        }
+                        
+                        std::cout << "  " << std::left << std::setw(10) << numObjects << std::setw(10) << zones
+                                  << std::right << std::fixed << std::setprecision(3)
+                                  << std::setw(14) << 1000 * associationSeconds / numFrames
+                                  << std::setw(14) << 1000 * seconds / numFrames
+                                  << std::setw(14) << std::setprecision(1) << tracksPerFrame
+                                  << std::setw(14) << numIds
+                                  << std::setw(14) << numSwitches << std::endl;
+                    }
+                }
+                std::cout << "  (associate is summed over the zones, which run in parallel; tracks is the mean number"
+                          << " of objects reported per frame; switches is how many times an object's ID changed)" << std::endl;
+            }
+            
+            // Track the sequence, returning the seconds spent in update and appending every
+            // output's ID, location, and trajectory to record.
+            double recordSequence(OT::MultiObjectTracker& tracker, const std::vector<FrameDetections>& sequence, std::vector<int>& record) {
+                std::vector<OT::TrackingOutput> outputs;
+                double seconds = 0;
+                for (const auto& frame : sequence) {
+                    auto start = Clock::now();
+                    tracker.update(frame.massCenters, frame.boundingBoxes, outputs);
+                    seconds += std::chrono::duration<double>(Clock::now() - start).count();
+                    for (const auto& output : outputs) {
+                        record.insert(record.end(), {output.id, output.location.x, output.location.y});
+                        for (size_t t = 0; t < output.trajectory.size(); t++) {
+                            record.insert(record.end(), {output.trajectory[t].x, output.trajectory[t].y});
+                        }
+                    }
+                }
+                return seconds;
+            }
+            
+            void benchmarkParallel(const cli::Parser& parser) {
+                const int numFrames = 300;
+                const cv::Size size(3200, 2400);
+                const std::vector<int> objectCounts = {100, 200, 400};
+                
+                std::cout << "Serial and parallel tracker updates on synthetic " << numFrames << " frame sequences in a "
+                          << size.width << " x " << size.height << " scene (ms per frame, "
+                          << parser.get<std::string>("as") << " association, " << cv::getNumThreads() << " threads)" << std::endl;
+                std::cout << "  " << std::left << std::setw(10) << "objects"
+                          << std::right << std::setw(14) << "serial" << std::setw(14) << "parallel"
+                          << std::setw(14) << "identical" << std::endl;
+                
+                cv::RNG rng(12345);
+                for (int numObjects : objectCounts) {
+                    auto sequence = makeCrowdedSequence(numObjects, numFrames, size, rng);
+                    double seconds[2];
+                    std::vector<int> records[2];
+                    for (int parallel = 0; parallel < 2; parallel++) {
+                        OT::MultiObjectTracker tracker(cv::Size(size.height, size.width));
+                        if (!tracker.setAssociation(parser.get<std::string>("as"))) {
+                            std::cerr << "Unknown association: " << parser.get<std::string>("as") << std::endl;
+                            return;
+                        }
+                        tracker.setCascade(parser.get<bool>("ca"));
+                        tracker.setMinParallelTrackers(parallel);
+                        seconds[parallel] = recordSequence(tracker, sequence, records[parallel]);
+                    }
+                    
+                    std::cout << "  " << std::left << std::setw(10) << numObjects
+                              << std::right << std::fixed << std::setprecision(3)
+                              << std::setw(14) << 1000 * seconds[0] / numFrames
+                              << std::setw(14) << 1000 * seconds[1] / numFrames
+                              << std::setw(14) << (records[0] == records[1] ? "yes" : "no") << std::endl;
+                }
+            }
+            
+            int run(const cli::Parser& parser) {
+                auto benchmark = parser.get<std::string>("b");
+                if (benchmark == "luma") {
+                    benchmarkLuma(parser);
+                } else if (benchmark == "tracking") {
+                    return benchmarkTracking(parser) ? 0 : 1;
+                } else if (benchmark == "assignment") {
+                    benchmarkAssignment(parser);
+                } else if (benchmark == "association") {
+                    benchmarkAssociation(parser);
+                } else if (benchmark == "partitioned") {
+                    benchmarkPartitioned(parser);
+                } else if (benchmark == "parallel") {
+                    benchmarkParallel(parser);
+                } else {
+                    std::cerr << "Unknown benchmark: " << benchmark << std::endl;
+                    return 1;
+                }
+                return 0;
+            }
+        } // Benchmark
+    } // Mode
+} // OT
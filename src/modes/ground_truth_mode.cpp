@@ -5,7 +5,7 @@
 #include "lib/cmdparser.hpp"
 #include "ground_truth/ground_truth_log.hpp"
 #include "utils/utils.hpp"
-#include "utils/perspective_transformer.hpp"
+#include "utils/frame_transformer.hpp"
 
 namespace OT {
     namespace Mode {
@@ -37,7 +37,9 @@ namespace OT {
             }
             
             void run(const cli::Parser& parser) {
-                // We'll use this variable to store the current frame captured from the video.
+                // We'll use these variables to store the current frame captured from the video,
+                // and the frame after it has been transformed.
+                cv::Mat rawFrame;
                 cv::Mat frame;
                 
                 // This object represents the video or image sequence that we are reading from.
@@ -63,38 +65,33 @@ namespace OT {
                     std::cerr << "Problem opening video source" << std::endl;
                 }
                 
+                // In headless mode, we never create windows, draw, or poll the keyboard.
+                bool headless = parser.get<bool>("hl");
+                
                 // Set the mouse callback.
-                cv::namedWindow("Video");
-                cv::setMouseCallback("Video", mouseHandler);
+                if (!headless) {
+                    cv::namedWindow("Video");
+                    cv::setMouseCallback("Video", mouseHandler);
+                }
                 
                 // Determine how to scale the video.
                 int maxDimension = parser.get<int>("d");
                 
-                // Get the perspective transform, if there is one.
-                auto perspectivePoints = parser.get<std::vector<int>>("p");
-                cv::Mat perspectiveMatrix;
-                cv::Size perspectiveSize;
-                std::vector<cv::Point2f> points;
-                OT::Perspective::extractFourPoints(perspectivePoints, points);
-                if (!points.empty()) {
-                    perspectiveMatrix = OT::Perspective::getPerspectiveMatrix(points, perspectiveSize);
-                }
+                // This applies the perspective transform (if there is one) and the scaling in one pass.
+                OT::FrameTransformer frameTransformer(parser.get<std::vector<int>>("p"), maxDimension);
                 
-                while(OT::Utils::hasFrame(capture)) {
+                while(OT::Utils::hasFrame(capture, headless)) {
                     // Fetch the next frame.
-                    capture.retrieve(frame);
+                    capture.retrieve(rawFrame);
                     frameNumber++;
                     
-                    // Do the perspective transform.
-                    if (!points.empty()) {
-                        cv::warpPerspective(frame, frame, perspectiveMatrix, perspectiveSize);
-                    }
-                    
-                    // Scale the image.
-                    OT::Utils::scale(frame, maxDimension);
+                    // Do the perspective transform and scale the image.
+                    frameTransformer.transform(rawFrame, frame);
                     
                     // Show the frame
-                    imshow("Video", frame);
+                    if (!headless) {
+                        imshow("Video", frame);
+                    }
                     
                     if (triggerCallback) {
                         logger.addAnnotation(currentAnnotation);
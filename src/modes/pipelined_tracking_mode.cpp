@@ -0,0 +1,255 @@
+#include "modes/pipelined_tracking_mode.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include "modes/tracking_stage.hpp"
+#include "utils/bounded_queue.hpp"
+#include "tracker/contour_finder.hpp"
+#include "lib/cmdparser.hpp"
+#include "utils/utils.hpp"
+#include "utils/frame_transformer.hpp"
+
+namespace OT {
+    namespace Mode {
+        namespace PipelinedTracking {
+            // A frame as it moves through the pipeline. Each stage fills in more of it.
+            struct PipelineFrame {
+                long frameNumber;
+                
+                // The frame as decoded from the video (only kept if we need to show it).
+                cv::Mat original;
+                
+                // The perspective transformed and scaled frame.
+                cv::Mat frame;
+                
+                // The output of the contour finder.
+                std::vector<std::vector<cv::Point>> contours;
+                std::vector<cv::Point2f> massCenters;
+                std::vector<cv::Rect> boundingBoxes;
+            };
+            
+            // Rectangles drawn by the user on the tracking thread which the detection thread
+            // must hand to its contour finder.
+            std::mutex suppressMutex;
+            std::vector<cv::Rect> pendingSuppressRectangles;
+            
+            // The mouse callback to allow the user to draw a rectangle on the screen.
+            bool isDragging = false;
+            bool hasRectangle = false;
+            cv::Point point1, point2;
+            
+            void mouseHandler(int event, int x, int y, int flags, void* param) {
+                if (event == CV_EVENT_LBUTTONDOWN && !isDragging) {
+                    point1 = cv::Point(x, y);
+                    std::cout << "Clicked " << point1 << std::endl;
+                    isDragging = true;
+                } else if (event == CV_EVENT_MOUSEMOVE && isDragging) {
+                    point2 = cv::Point(x, y);
+                    hasRectangle = true;
+                } else if (event == CV_EVENT_LBUTTONUP && isDragging) {
+                    point2 = cv::Point(x, y);
+                    isDragging = false;
+                    hasRectangle = false;
+                    std::lock_guard<std::mutex> lock(suppressMutex);
+                    pendingSuppressRectangles.push_back(cv::Rect(point1, point2));
+                }
+            }
+            
+            // Print the stats for a stage which reads from input (if any) and writes to output (if any).
+            void printStageStats(const std::string& name,
+                                 const OT::BoundedQueue<PipelineFrame>* input,
+                                 const OT::BoundedQueue<PipelineFrame>* output) {
+                std::cout << "  " << std::left << std::setw(12) << name;
+                if (input != nullptr) {
+                    auto stats = input->stats();
+                    std::cout << " waited for input " << std::fixed << std::setprecision(3)
+                              << stats.popStallSeconds << "s";
+                }
+                if (output != nullptr) {
+                    auto stats = output->stats();
+                    std::cout << " blocked on output " << std::fixed << std::setprecision(3)
+                              << stats.pushStallSeconds << "s"
+                              << " (queue depth mean " << std::setprecision(2) << stats.meanDepth
+                              << ", max " << stats.maxDepth << "/" << stats.capacity << ")";
+                }
+                std::cout << std::endl;
+            }
+            
+            void run(const cli::Parser& parser) {
+                // This object represents the video or image sequence that we are reading from.
+                cv::VideoCapture capture;
+                
+                // In headless mode, we never create windows, draw, or poll the keyboard.
+                bool headless = parser.get<bool>("hl");
+                
+                // Whether to find blobs with connected component labeling instead of contours.
+                bool connectedComponents = parser.get<bool>("cc");
+                
+                // The capacity of each queue between stages.
+                int queueSize = parser.get<int>("qs");
+                
+                // This applies the perspective transform (if there is one) and the scaling in one pass.
+                // If we're warping detections, the frames are only scaled and the perspective transform
+                // is applied to the mass centers and bounding boxes we find instead. With luma, the
+                // frames we detect objects in are grayscale.
+                OT::FrameTransformer frameTransformer(parser.get<std::vector<int>>("p"),
+                                                      parser.get<int>("d"),
+                                                      parser.get<bool>("wd"),
+                                                      parser.get<bool>("lu"));
+                
+                // This tracks, draws, and logs the objects we find.
+                OT::Mode::TrackingStage trackingStage(parser, frameTransformer);
+                
+                OT::Mode::openVideoSource(parser, capture);
+                
+                // Set the mouse callback.
+                if (!headless) {
+                    cv::namedWindow("Video");
+                    cv::namedWindow("Original");
+                    cv::setMouseCallback("Video", mouseHandler);
+                    cv::setMouseCallback("Original", mouseHandler);
+                }
+                
+                // The queues between the stages.
+                OT::BoundedQueue<PipelineFrame> decoded(queueSize);
+                OT::BoundedQueue<PipelineFrame> preprocessed(queueSize);
+                OT::BoundedQueue<PipelineFrame> detected(queueSize);
+                
+                // Set when the user quits, so the decoder stops reading.
+                std::atomic<bool> hasQuit(false);
+                
+                auto startTime = std::chrono::steady_clock::now();
+                
+                // Decode stage.
+                std::thread decodeThread([&]() {
+                    long frameNumber = 0;
+                    while (!hasQuit && capture.grab()) {
+                        PipelineFrame item;
+                        item.frameNumber = ++frameNumber;
+                        capture.retrieve(item.frame);
+                        if (!decoded.push(std::move(item))) {
+                            break;
+                        }
+                    }
+                    decoded.close();
+                });
+                
+                // Preprocess stage.
+                std::thread preprocessThread([&]() {
+                    PipelineFrame item;
+                    while (decoded.pop(item)) {
+                        // Do the perspective transform and scale the image.
+                        cv::Mat transformed;
+                        frameTransformer.transform(item.frame, transformed);
+                        if (!headless) {
+                            item.original = item.frame;
+                        }
+                        item.frame = transformed;
+                        
+                        if (!preprocessed.push(std::move(item))) {
+                            break;
+                        }
+                    }
+                    preprocessed.close();
+                });
+                
+                // Detection stage.
+                std::thread detectThread([&]() {
+                    // The contour finder lives entirely on this thread.
+                    OT::ContourFinder contourFinder;
+                    contourFinder.setHeadless(true);
+                    contourFinder.setConnectedComponents(connectedComponents);
+                    std::vector<cv::Vec4i> hierarchy;
+                    
+                    PipelineFrame item;
+                    while (preprocessed.pop(item)) {
+                        {
+                            std::lock_guard<std::mutex> lock(suppressMutex);
+                            for (auto rect : pendingSuppressRectangles) {
+                                contourFinder.suppressRectangle(frameTransformer.rectToFrame(rect));
+                            }
+                            pendingSuppressRectangles.clear();
+                        }
+                        
+                        contourFinder.findContours(item.frame,
+                                                   hierarchy,
+                                                   item.contours,
+                                                   item.massCenters,
+                                                   item.boundingBoxes);
+                        
+                        if (!detected.push(std::move(item))) {
+                            break;
+                        }
+                    }
+                    detected.close();
+                });
+                
+                // Tracking stage. This runs on the calling thread because that's where
+                // windows have to be shown.
+                long numFrames = 0;
+                PipelineFrame item;
+                while (detected.pop(item)) {
+                    numFrames++;
+                    
+                    // This is what we draw on and show (the frame in perspective transformed coordinates).
+                    cv::Mat frame;
+                    if (!headless) {
+                        imshow("Original", item.original);
+                    }
+                    
+                    // Track the objects the detection stage found.
+                    trackingStage.track(item.frameNumber,
+                                        item.frame,
+                                        item.contours,
+                                        item.massCenters,
+                                        item.boundingBoxes,
+                                        frame);
+                    
+                    if (!headless) {
+                        // Show the rectangle the user is dragging.
+                        if (hasRectangle) {
+                            cv::rectangle(frame, point1, point2, cv::Scalar::all(255));
+                        }
+                        imshow("Video", frame);
+                        
+                        // Quit if the user has pressed "q".
+                        if (((char) cv::waitKey(1)) == 'q') {
+                            break;
+                        }
+                    }
+                }
+                
+                // Shut down the rest of the pipeline.
+                hasQuit = true;
+                decoded.close();
+                preprocessed.close();
+                detected.close();
+                decodeThread.join();
+                preprocessThread.join();
+                detectThread.join();
+                
+                // Report how well the pipeline kept its stages busy.
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+                std::cout << "Pipeline processed " << numFrames << " frames in " << std::fixed
+                          << std::setprecision(3) << seconds << "s ("
+                          << std::setprecision(2) << (seconds > 0 ? numFrames / seconds : 0) << " FPS)" << std::endl;
+                printStageStats("decode", nullptr, &decoded);
+                printStageStats("preprocess", &decoded, &preprocessed);
+                printStageStats("detect", &preprocessed, &detected);
+                printStageStats("track", &detected, nullptr);
+                
+                trackingStage.finish();
+            } // run
+        } // PipelinedTracking
+    } // Mode
+} // OT
@@ -9,7 +9,7 @@
 #include "lib/cmdparser.hpp"
 #include "lib/csv.hpp"
 #include "utils/utils.hpp"
-#include "utils/perspective_transformer.hpp"
+#include "utils/frame_transformer.hpp"
 
 /**
  * Plots points listed in the (timestamp, x, y, frame) CSV overlaid on a video.
@@ -43,7 +43,9 @@ namespace OT {
             }
             
             void run(const cli::Parser& parser) {
-                // We'll use this variable to store the current frame captured from the video.
+                // We'll use these variables to store the current frame captured from the video,
+                // and the frame after it has been transformed.
+                cv::Mat rawFrame;
                 cv::Mat frame;
                 
                 // This object represents the video or image sequence that we are reading from.
@@ -87,29 +89,20 @@ namespace OT {
                 // Determine how to scale the video.
                 int maxDimension = parser.get<int>("d");
                 
-                // Get the perspective transform, if there is one.
-                auto perspectivePoints = parser.get<std::vector<int>>("p");
-                cv::Mat perspectiveMatrix;
-                cv::Size perspectiveSize;
-                std::vector<cv::Point2f> points;
-                OT::Perspective::extractFourPoints(perspectivePoints, points);
-                if (!points.empty()) {
-                    perspectiveMatrix = OT::Perspective::getPerspectiveMatrix(points, perspectiveSize);
-                }
+                // In headless mode, we never create windows, draw, or poll the keyboard.
+                bool headless = parser.get<bool>("hl");
+                
+                // This applies the perspective transform (if there is one) and the scaling in one pass.
+                OT::FrameTransformer frameTransformer(parser.get<std::vector<int>>("p"), maxDimension);
                 
                 // Repeat while the user has not pressed "q" and while there's another frame.
-                while(OT::Utils::hasFrame(capture)) {
+                while(OT::Utils::hasFrame(capture, headless)) {
                     // Fetch the next frame.
-                    capture.retrieve(frame);
+                    capture.retrieve(rawFrame);
                     frameNumber++;
                     
-                    // Do the perspective transform.
-                    if (!points.empty()) {
-                        cv::warpPerspective(frame, frame, perspectiveMatrix, perspectiveSize);
-                    }
-                    
-                    // Scale the image.
-                    OT::Utils::scale(frame, maxDimension);
+                    // Do the perspective transform and scale the image.
+                    frameTransformer.transform(rawFrame, frame);
                     
                     // Update the current track entry.
                     if (entryForFrame.find(frameNumber) != entryForFrame.end()) {
@@ -120,6 +113,11 @@ namespace OT {
                         currentTrackEntry2 = entryForFrame2.at(frameNumber);
                     }
                     
+                    // Nothing else to do if we can't show the frame.
+                    if (headless) {
+                        continue;
+                    }
+                    
                     // If we have something to draw this frame, draw it.
                     cv::circle(frame,
                                cv::Point(currentTrackEntry.x, frame.rows - currentTrackEntry.y),
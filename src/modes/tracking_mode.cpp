@@ -3,20 +3,16 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <fstream>
 
 #include <opencv2/opencv.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/video/tracking.hpp>
 
-#include "utils/draw_utils.hpp"
-#include "tracker/kalman_tracker.hpp"
-#include "tracker/multi_object_tracker.hpp"
+#include "modes/tracking_stage.hpp"
 #include "tracker/contour_finder.hpp"
-#include "tracker/tracker_log.hpp"
 #include "lib/cmdparser.hpp"
 #include "utils/utils.hpp"
-#include "utils/perspective_transformer.hpp"
+#include "utils/frame_transformer.hpp"
 
 namespace OT {
     namespace Mode {
@@ -47,14 +43,14 @@ namespace OT {
             
             void run(const cli::Parser& parser) {
                 
-                // This does the actual tracking of the objects. We can't initialize it now because
-                // it needs to know the size of the frame. So, we set it equal to nullptr and initialize
-                // it after we get the first frame.
-                std::unique_ptr<OT::MultiObjectTracker> tracker = nullptr;
-                
-                // We'll use this variable to store the current frame captured from the video.
+                // We'll use these variables to store the current frame captured from the video,
+                // and the frame after it has been transformed.
+                cv::Mat rawFrame;
                 cv::Mat frame;
                 
+                // This is what we draw on and show (the frame in perspective transformed coordinates).
+                cv::Mat display;
+                
                 // This object represents the video or image sequence that we are reading from.
                 cv::VideoCapture capture;
                 
@@ -64,123 +60,81 @@ namespace OT {
                 std::vector<cv::Vec4i> hierarchy;
                 std::vector<std::vector<cv::Point> > contours;
                 
+                // The mass centers and bounding boxes of the objects in the current frame. They're
+                // reused so that they keep their capacity from frame to frame.
+                std::vector<cv::Point2f> mc;
+                std::vector<cv::Rect> boundRect;
+                
                 // We'll use a ContourFinder to do the actual extraction of contours from the image.
                 OT::ContourFinder contourFinder;
                 
                 // We'll count the frame with this variable.
                 long frameNumber = 0;
                 
-                // This will log all of the tracked objects.
-                OT::TrackerLog trackerLog(true);
-                
-                // Determine how to scale the video.
-                int maxDimension = parser.get<int>("d");
-                
-                // Read from the webcam or the parser.
-                if (parser.get<int>("w") != -1) {
-                    capture.open(parser.get<int>("w"));
-                } else {
-                    capture.open(parser.get<std::string>("i"));
-                }
+                // In headless mode, we never create windows, draw, or poll the keyboard.
+                bool headless = parser.get<bool>("hl");
+                contourFinder.setHeadless(headless);
+                contourFinder.setConnectedComponents(parser.get<bool>("cc"));
                 
-                // Get the perspective transform, if there is one.
-                auto perspectivePoints = parser.get<std::vector<int>>("p");
-                cv::Mat perspectiveMatrix;
-                cv::Size perspectiveSize;
-                std::vector<cv::Point2f> points;
-                OT::Perspective::extractFourPoints(perspectivePoints, points);
-                if (!points.empty()) {
-                    perspectiveMatrix = OT::Perspective::getPerspectiveMatrix(points, perspectiveSize);
-                }
+                // This applies the perspective transform (if there is one) and the scaling in one pass.
+                // If we're warping detections, the frames are only scaled and the perspective transform
+                // is applied to the mass centers and bounding boxes we find instead. With luma, the
+                // frames we detect objects in are grayscale.
+                OT::FrameTransformer frameTransformer(parser.get<std::vector<int>>("p"),
+                                                      parser.get<int>("d"),
+                                                      parser.get<bool>("wd"),
+                                                      parser.get<bool>("lu"));
                 
-                // Read the second positional command line argument and use that as the log
-                // for the output file.
-                std::string outputFilePath = parser.get<std::string>("s");
-                std::ofstream outputFile;
-                if (!outputFilePath.empty()) {
-                    outputFile.open(outputFilePath);
-                }
+                // This tracks, draws, and logs the objects we find.
+                OT::Mode::TrackingStage trackingStage(parser, frameTransformer);
                 
-                // Ensure that the video has been opened correctly.
-                if(!capture.isOpened()) {
-                    std::cerr << "Problem opening video source" << std::endl;
-                }
+                OT::Mode::openVideoSource(parser, capture);
                 
                 // Set the mouse callback.
-                cv::namedWindow("Video");
-                cv::namedWindow("Original");
-                cv::setMouseCallback("Video", mouseHandler);
-                cv::setMouseCallback("Original", mouseHandler);
+                if (!headless) {
+                    cv::namedWindow("Video");
+                    cv::namedWindow("Original");
+                    cv::setMouseCallback("Video", mouseHandler);
+                    cv::setMouseCallback("Original", mouseHandler);
+                }
                 
                 
                 // Repeat while the user has not pressed "q" and while there's another frame.
-                while(OT::Utils::hasFrame(capture)) {
+                while(OT::Utils::hasFrame(capture, headless)) {
                     // Fetch the next frame.
-                    capture.retrieve(frame);
+                    capture.retrieve(rawFrame);
                     frameNumber++;
                     
-                    imshow("Original", frame);
-                    
-                    // Do the perspective transform.
-                    if (!points.empty()) {
-                        cv::warpPerspective(frame, frame, perspectiveMatrix, perspectiveSize);
+                    if (!headless) {
+                        imshow("Original", rawFrame);
                     }
                     
-                    // Scale the image.
-                    OT::Utils::scale(frame, maxDimension);
-                    
-                    // Create the tracker if it isn't created yet.
-                    if (tracker == nullptr) {
-                        tracker = std::make_unique<OT::MultiObjectTracker>(cv::Size(frame.rows, frame.cols));
-                    }
-                    
-                    // Set the frame dimension.
-                    trackerLog.setDimensions(frame.cols, frame.rows);
+                    // Do the perspective transform and scale the image.
+                    frameTransformer.transform(rawFrame, frame);
                     
                     // Find the contours.
-                    std::vector<cv::Point2f> mc(contours.size());
-                    std::vector<cv::Rect> boundRect(contours.size());
                     contourFinder.findContours(frame, hierarchy, contours, mc, boundRect);
                     
-                    OT::DrawUtils::contourShow("Contours", contours, boundRect, frame.size());
-                    
-                    // Update the predicted locations of the objects based on the observed
-                    // mass centers.
-                    std::vector<OT::TrackingOutput> predictions;
-                    tracker->update(mc, boundRect, predictions);
-                    
-                    for (auto pred : predictions) {
-                        // Draw a cross at the location of the prediction.
-                        OT::DrawUtils::drawCross(frame, pred.location, pred.color, 5);
-                        
-                        // Draw the trajectory for the prediction.
-                        OT::DrawUtils::drawTrajectory(frame, pred.trajectory, pred.color);
-                        
-                        // Update the tracker log.
-                        if (!outputFilePath.empty()) {
-                            trackerLog.addTrack(pred.id, pred.location.x, pred.location.y, frameNumber);
-                        }
-                    }
+                    // Track the objects we found.
+                    trackingStage.track(frameNumber, frame, contours, mc, boundRect, display);
                     
                     // Handle mouse callbacks.
                     if (hasRectangle || triggerCallback) {
-                        cv::rectangle(frame, point1, point2, cv::Scalar::all(255));
+                        cv::rectangle(display, point1, point2, cv::Scalar::all(255));
                     }
                     
                     if (triggerCallback) {
                         triggerCallback = false;
-                        contourFinder.suppressRectangle(cv::Rect(point1, point2));
+                        contourFinder.suppressRectangle(frameTransformer.rectToFrame(cv::Rect(point1, point2)));
                     }
                     
-                    imshow("Video", frame);
+                    if (!headless) {
+                        imshow("Video", display);
+                    }
                 }
                 
                 
-                // Log the output file if we need to.
-                if (!outputFilePath.empty()) {
-                    trackerLog.logToFile(outputFile);
-                    outputFile.close();
-                }
+                trackingStage.finish();
             } // run
         } // Tracking
     } // Mode
@@ -0,0 +1,116 @@
+#include "modes/tracking_stage.hpp"
+
+#include <iostream>
+
+#include "utils/draw_utils.hpp"
+
+namespace OT {
+    namespace Mode {
+        void openVideoSource(const cli::Parser& parser, cv::VideoCapture& capture) {
+            // Read from the webcam or the parser.
+            if (parser.get<int>("w") != -1) {
+                capture.open(parser.get<int>("w"));
+            } else {
+                capture.open(parser.get<std::string>("i"));
+            }
+            
+            // Ensure that the video has been opened correctly.
+            if(!capture.isOpened()) {
+                std::cerr << "Problem opening video source" << std::endl;
+            }
+        }
+        
+        TrackingStage::TrackingStage(const cli::Parser& parser, OT::FrameTransformer& frameTransformer)
+            : parser(parser), frameTransformer(frameTransformer), trackerLog(true) {
+            this->headless = parser.get<bool>("hl");
+            this->tracker = nullptr;
+            this->partitionedTracker = nullptr;
+            
+            // Read the support file path and use that as the log for the output file.
+            this->outputFilePath = parser.get<std::string>("s");
+            if (!this->outputFilePath.empty()) {
+                this->outputFile.open(this->outputFilePath);
+            }
+        }
+        
+        void TrackingStage::track(long frameNumber,
+                                  const cv::Mat& frame,
+                                  const std::vector<std::vector<cv::Point>>& contours,
+                                  std::vector<cv::Point2f>& massCenters,
+                                  std::vector<cv::Rect>& boundingBoxes,
+                                  cv::Mat& display) {
+            if (!this->headless) {
+                OT::DrawUtils::contourShow("Contours", contours, boundingBoxes, frame.size());
+                this->frameTransformer.rectify(frame, display);
+            }
+            
+            // Move the detections into the perspective transformed coordinates if needed.
+            this->frameTransformer.transformDetections(massCenters, boundingBoxes);
+            
+            // The size of the space that the objects are tracked in.
+            cv::Size trackingSize = this->frameTransformer.detectionSize(frame.size());
+            
+            // Create the tracker if it isn't created yet.
+            if (this->tracker == nullptr && this->partitionedTracker == nullptr) {
+                this->createTracker(trackingSize);
+            }
+            
+            // Set the frame dimension.
+            this->trackerLog.setDimensions(trackingSize.width, trackingSize.height);
+            
+            // Update the predicted locations of the objects based on the observed
+            // mass centers.
+            if (this->partitionedTracker != nullptr) {
+                this->partitionedTracker->update(massCenters, boundingBoxes, this->predictions);
+            } else {
+                this->tracker->update(massCenters, boundingBoxes, this->predictions);
+            }
+            
+            for (const auto& pred : this->predictions) {
+                if (!this->headless) {
+                    // Draw a cross at the location of the prediction.
+                    OT::DrawUtils::drawCross(display, pred.location, pred.color, 5);
+                    
+                    // Draw the trajectory for the prediction.
+                    OT::DrawUtils::drawTrajectory(display, pred.trajectory, pred.color);
+                }
+                
+                // Update the tracker log.
+                if (!this->outputFilePath.empty()) {
+                    this->trackerLog.addTrack(pred, frameNumber);
+                }
+            }
+        }
+        
+        void TrackingStage::createTracker(cv::Size trackingSize) {
+            std::vector<int> zoneGrid = this->parser.get<std::vector<int>>("zg");
+            if (!zoneGrid.empty() && zoneGrid.size() != 2) {
+                std::cerr << "The zone grid (-zg) should be a number of columns and a number of rows" << std::endl;
+            }
+            
+            if (zoneGrid.size() == 2 && zoneGrid[0] * zoneGrid[1] > 1) {
+                this->partitionedTracker = std::make_unique<OT::PartitionedTracker>(trackingSize, zoneGrid[0], zoneGrid[1]);
+                if (!this->partitionedTracker->setAssociation(this->parser.get<std::string>("as"))) {
+                    std::cerr << "Unknown association: " << this->parser.get<std::string>("as") << std::endl;
+                }
+                this->partitionedTracker->setCascade(this->parser.get<bool>("ca"));
+                this->partitionedTracker->setMinParallelTrackers(this->parser.get<int>("pt"));
+            } else {
+                this->tracker = std::make_unique<OT::MultiObjectTracker>(cv::Size(trackingSize.height, trackingSize.width));
+                if (!this->tracker->setAssociation(this->parser.get<std::string>("as"))) {
+                    std::cerr << "Unknown association: " << this->parser.get<std::string>("as") << std::endl;
+                }
+                this->tracker->setCascade(this->parser.get<bool>("ca"));
+                this->tracker->setMinParallelTrackers(this->parser.get<int>("pt"));
+            }
+        }
+        
+        void TrackingStage::finish() {
+            // Log the output file if we need to.
+            if (!this->outputFilePath.empty()) {
+                this->trackerLog.logToFile(this->outputFile);
+                this->outputFile.close();
+            }
+        }
+    }
+}
@@ -0,0 +1,223 @@
+#include "tracker/component_labeler.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+namespace OT {
+    BlobStats::BlobStats() {
+        this->area = 0;
+        this->sumX = 0;
+        this->sumY = 0;
+        this->minX = std::numeric_limits<int>::max();
+        this->minY = std::numeric_limits<int>::max();
+        this->maxX = std::numeric_limits<int>::min();
+        this->maxY = std::numeric_limits<int>::min();
+    }
+    
+    void BlobStats::addRun(int y, int startX, int endX) {
+        double length = endX - startX;
+        this->area += length;
+        this->sumX += length * (startX + endX - 1) / 2.0;
+        this->sumY += length * y;
+        this->minX = std::min(this->minX, startX);
+        this->maxX = std::max(this->maxX, endX - 1);
+        this->minY = std::min(this->minY, y);
+        this->maxY = std::max(this->maxY, y);
+    }
+    
+    void BlobStats::merge(const BlobStats& other) {
+        this->area += other.area;
+        this->sumX += other.sumX;
+        this->sumY += other.sumY;
+        this->minX = std::min(this->minX, other.minX);
+        this->maxX = std::max(this->maxX, other.maxX);
+        this->minY = std::min(this->minY, other.minY);
+        this->maxY = std::max(this->maxY, other.maxY);
+    }
+    
+    cv::Point2f BlobStats::massCenter() const {
+        return cv::Point2f(this->sumX / this->area, this->sumY / this->area);
+    }
+    
+    cv::Rect BlobStats::boundingBox() const {
+        return cv::Rect(this->minX, this->minY, this->maxX - this->minX + 1, this->maxY - this->minY + 1);
+    }
+    
+    /**
+     * Labels each strip on its own thread.
+     */
+    class StripLabelingBody : public cv::ParallelLoopBody {
+    private:
+        const cv::Mat& binary;
+        ComponentLabeler& labeler;
+    public:
+        StripLabelingBody(const cv::Mat& binary, ComponentLabeler& labeler) :
+        binary(binary), labeler(labeler) {
+        }
+        
+        virtual void operator()(const cv::Range& range) const {
+            for (int i = range.start; i < range.end; i++) {
+                ComponentLabeler::labelStrip(this->binary, this->labeler.strips[i]);
+            }
+        }
+    };
+    
+    ComponentLabeler::ComponentLabeler(int minStripHeight) {
+        this->minStripHeight = std::max(minStripHeight, 1);
+    }
+    
+    int ComponentLabeler::find(std::vector<int>& parent, int label) {
+        while (parent[label] != label) {
+            parent[label] = parent[parent[label]];
+            label = parent[label];
+        }
+        return label;
+    }
+    
+    void ComponentLabeler::join(std::vector<int>& parent, int a, int b) {
+        a = find(parent, a);
+        b = find(parent, b);
+        
+        // The smaller label becomes the root so that roots stay in scan order.
+        if (a < b) {
+            parent[b] = a;
+        } else if (b < a) {
+            parent[a] = b;
+        }
+    }
+    
+    void ComponentLabeler::joinRows(std::vector<int>& parent,
+                                    const std::vector<Run>& above, int aboveOffset,
+                                    const std::vector<Run>& below, int belowOffset) {
+        // Runs are sorted, so we sweep both rows together. Two runs are 8-connected if they
+        // overlap once the run below is widened by a pixel on each side.
+        size_t first = 0;
+        for (auto run : below) {
+            while (first < above.size() && above[first].end < run.start) {
+                first++;
+            }
+            for (size_t i = first; i < above.size() && above[i].start <= run.end; i++) {
+                join(parent, above[i].label + aboveOffset, run.label + belowOffset);
+            }
+        }
+    }
+    
+    void ComponentLabeler::labelStrip(const cv::Mat& binary, Strip& strip) {
+        strip.parent.clear();
+        strip.stats.clear();
+        strip.firstRow.clear();
+        strip.lastRow.clear();
+        strip.previous.clear();
+        
+        for (int y = strip.startRow; y < strip.endRow; y++) {
+            const uchar* row = binary.ptr<uchar>(y);
+            strip.current.clear();
+            
+            // Find the runs in this row and give each one a provisional label.
+            size_t first = 0;
+            int x = 0;
+            while (x < binary.cols) {
+                if (row[x] == 0) {
+                    x++;
+                    continue;
+                }
+                int start = x;
+                while (x < binary.cols && row[x] != 0) {
+                    x++;
+                }
+                Run run{start, x, -1};
+                
+                // Join with every touching run in the previous row.
+                while (first < strip.previous.size() && strip.previous[first].end < run.start) {
+                    first++;
+                }
+                for (size_t i = first; i < strip.previous.size() && strip.previous[i].start <= run.end; i++) {
+                    if (run.label == -1) {
+                        run.label = find(strip.parent, strip.previous[i].label);
+                    } else {
+                        join(strip.parent, run.label, strip.previous[i].label);
+                    }
+                }
+                
+                // Otherwise, it's the start of a new component.
+                if (run.label == -1) {
+                    run.label = (int) strip.parent.size();
+                    strip.parent.push_back(run.label);
+                    strip.stats.push_back(OT::BlobStats());
+                }
+                
+                strip.stats[run.label].addRun(y, run.start, run.end);
+                strip.current.push_back(run);
+            }
+            
+            if (y == strip.startRow) {
+                strip.firstRow = strip.current;
+            }
+            std::swap(strip.previous, strip.current);
+        }
+        strip.lastRow = strip.previous;
+    }
+    
+    void ComponentLabeler::label(const cv::Mat& binary, std::vector<OT::BlobStats>& blobs) {
+        CV_Assert(binary.type() == CV_8UC1);
+        blobs.clear();
+        
+        // Split the image into strips, one per thread.
+        int numStrips = std::max(1, std::min(cv::getNumThreads(), binary.rows / this->minStripHeight));
+        if ((int) this->strips.size() < numStrips) {
+            this->strips.resize(numStrips);
+        }
+        for (int i = 0; i < numStrips; i++) {
+            this->strips[i].startRow = (binary.rows * i) / numStrips;
+            this->strips[i].endRow = (binary.rows * (i + 1)) / numStrips;
+        }
+        
+        // Label the strips in parallel.
+        cv::parallel_for_(cv::Range(0, numStrips), StripLabelingBody(binary, *this));
+        
+        // Put all the provisional labels into one union-find, offsetting each strip's labels.
+        this->offsets.assign(numStrips, 0);
+        this->parent.clear();
+        for (int i = 0; i < numStrips; i++) {
+            this->offsets[i] = (int) this->parent.size();
+            for (auto p : this->strips[i].parent) {
+                this->parent.push_back(p + this->offsets[i]);
+            }
+        }
+        
+        // Join the components that cross strip boundaries.
+        for (int i = 0; i + 1 < numStrips; i++) {
+            joinRows(this->parent,
+                     this->strips[i].lastRow, this->offsets[i],
+                     this->strips[i + 1].firstRow, this->offsets[i + 1]);
+        }
+        
+        // Add up the statistics for each component.
+        this->blobForLabel.assign(this->parent.size(), -1);
+        for (int i = 0; i < numStrips; i++) {
+            for (size_t j = 0; j < this->strips[i].stats.size(); j++) {
+                int root = find(this->parent, this->offsets[i] + (int) j);
+                if (this->blobForLabel[root] == -1) {
+                    this->blobForLabel[root] = (int) blobs.size();
+                    blobs.push_back(OT::BlobStats());
+                }
+                blobs[this->blobForLabel[root]].merge(this->strips[i].stats[j]);
+            }
+        }
+    }
+    
+    size_t ComponentLabeler::reservedBytes() const {
+        size_t bytes = (this->parent.capacity() + this->blobForLabel.capacity() + this->offsets.capacity()) * sizeof(int);
+        bytes += this->strips.capacity() * sizeof(Strip);
+        for (const auto& strip : this->strips) {
+            bytes += strip.parent.capacity() * sizeof(int);
+            bytes += strip.stats.capacity() * sizeof(OT::BlobStats);
+            bytes += (strip.firstRow.capacity() + strip.lastRow.capacity()) * sizeof(Run);
+            bytes += (strip.previous.capacity() + strip.current.capacity()) * sizeof(Run);
+        }
+        return bytes;
+    }
+}
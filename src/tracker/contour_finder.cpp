@@ -1,13 +1,11 @@
 #include "tracker/contour_finder.hpp"
 
-#include <numeric>
-#include <unordered_map>
+#include <algorithm>
+#include <cmath>
 
 #include <opencv2/opencv.hpp>
 #include <opencv2/video/tracking.hpp>
 
-#include "lib/disjoint_set.hpp"
-
 namespace OT {
     ContourFinder::ContourFinder(int history,
                                  int nMixtures,
@@ -23,64 +21,164 @@ namespace OT {
         this->contourSizeThreshold = contourSizeThreshold;
         this->medianFilterSize = medianFilterSize;
         this->contourMergeThreshold = contourMergeThreshold;
+        this->headless = false;
+        this->connectedComponents = false;
+        this->workspaceBytes = 0;
+        this->numBufferGrowths = 0;
+    }
+    
+    size_t ContourFinderWorkspace::reservedBytes() const {
+        size_t bytes = this->filtered.total() * this->filtered.elemSize();
+        bytes += (this->blobs.capacity() * sizeof(OT::BlobStats) +
+                  this->blobBoxes.capacity() * sizeof(cv::Rect) +
+                  this->contourPolygon.capacity() * sizeof(cv::Point));
+        bytes += (this->cellStart.capacity() + this->cellEntries.capacity() +
+                  this->cellFill.capacity() + this->lastVisitedBy.capacity()) * sizeof(int);
+        bytes += this->mergePairs.capacity() * sizeof(std::pair<int, int>);
+        bytes += this->mergeSets.ReservedBytes() + this->mergeSetIds.capacity() * sizeof(int);
+        return bytes;
     }
     
-    cv::Point translate(cv::Rect rect, std::pair<int, int> widthHeight) {
-        return cv::Point(rect.tl().x + widthHeight.first * rect.width,
-                         rect.tl().y + widthHeight.second * rect.height);
+    // The smallest distance between two values, one taken from each pair.
+    int minDifference(int a1, int a2, int b1, int b2) {
+        return std::min(std::min(std::abs(a1 - b1), std::abs(a1 - b2)),
+                        std::min(std::abs(a2 - b1), std::abs(a2 - b2)));
     }
     
+    /**
+     * The smallest distance between a corner of a and a corner of b. Every combination of
+     * x edge and y edge is a corner, so we can minimize the x and y differences separately.
+     */
     float distanceBetweenRects(cv::Rect a, cv::Rect b) {
-        std::vector<std::pair<int, int>> pairs = {
-            std::make_pair(0, 0),
-            std::make_pair(0, 1),
-            std::make_pair(1, 0),
-            std::make_pair(1, 1)
+        double dx = minDifference(a.x, a.x + a.width, b.x, b.x + b.width);
+        double dy = minDifference(a.y, a.y + a.height, b.y, b.y + b.height);
+        return std::sqrt(dx * dx + dy * dy);
+    }
+    
+    void ContourFinder::findMergePairs(const std::vector<cv::Rect>& boundingBoxes) {
+        this->workspace.mergePairs.clear();
+        int numBoxes = (int) boundingBoxes.size();
+        if (numBoxes < 2) {
+            return;
+        }
+        float threshold = this->contourMergeThreshold * this->diagonal;
+        
+        // Find the extent of the boxes (including their far edges) and their typical size.
+        int minX = boundingBoxes[0].x, maxX = minX;
+        int minY = boundingBoxes[0].y, maxY = minY;
+        double meanSize = 0;
+        for (auto box : boundingBoxes) {
+            minX = std::min(minX, box.x);
+            minY = std::min(minY, box.y);
+            maxX = std::max(maxX, box.x + box.width);
+            maxY = std::max(maxY, box.y + box.height);
+            meanSize += std::max(box.width, box.height);
+        }
+        meanSize /= numBoxes;
+        
+        // Cells are about as big as a box, but never so small that the grid gets huge.
+        double cellSize = std::max({(double) threshold, meanSize, (maxX - minX) / 256.0, (maxY - minY) / 256.0, 1.0});
+        int gridCols = (int) ((maxX - minX) / cellSize) + 1;
+        int gridRows = (int) ((maxY - minY) / cellSize) + 1;
+        auto cellColumn = [&](double x) {
+            return std::max(0, std::min(gridCols - 1, (int) std::floor((x - minX) / cellSize)));
+        };
+        auto cellRow = [&](double y) {
+            return std::max(0, std::min(gridRows - 1, (int) std::floor((y - minY) / cellSize)));
         };
         
-        double minDist = cv::norm(a.tl() - b.tl());
-        for (size_t i = 0; i < pairs.size(); i++) {
-            for (size_t j = 0; j < pairs.size(); j++) {
-                minDist = std::min(minDist,
-                                   cv::norm(translate(a, pairs[i])
-                                            - translate(b, pairs[j])
-                                            )
-                                   );
+        // Bucket the boxes by the cells they cover (counting sort, so every cell's
+        // boxes are contiguous and in increasing order).
+        this->workspace.cellStart.assign(gridCols * gridRows + 1, 0);
+        for (int pass = 0; pass < 2; pass++) {
+            if (pass == 1) {
+                for (size_t c = 1; c < this->workspace.cellStart.size(); c++) {
+                    this->workspace.cellStart[c] += this->workspace.cellStart[c - 1];
+                }
+                this->workspace.cellEntries.resize(this->workspace.cellStart.back());
+                this->workspace.cellFill.assign(this->workspace.cellStart.begin(), this->workspace.cellStart.end() - 1);
             }
+            for (int i = 0; i < numBoxes; i++) {
+                const cv::Rect& box = boundingBoxes[i];
+                for (int r = cellRow(box.y); r <= cellRow(box.y + box.height); r++) {
+                    for (int c = cellColumn(box.x); c <= cellColumn(box.x + box.width); c++) {
+                        if (pass == 0) {
+                            this->workspace.cellStart[r * gridCols + c + 1]++;
+                        } else {
+                            this->workspace.cellEntries[this->workspace.cellFill[r * gridCols + c]++] = i;
+                        }
+                    }
+                }
+            }
+        }
+        
+        // Two boxes can only be close enough to merge if one of them, grown by the threshold,
+        // overlaps the other, so we only need to look at the cells the grown box covers.
+        this->workspace.lastVisitedBy.assign(numBoxes, -1);
+        for (int i = 0; i < numBoxes; i++) {
+            const cv::Rect& box = boundingBoxes[i];
+            size_t firstPair = this->workspace.mergePairs.size();
+            for (int r = cellRow(box.y - threshold); r <= cellRow(box.y + box.height + threshold); r++) {
+                for (int c = cellColumn(box.x - threshold); c <= cellColumn(box.x + box.width + threshold); c++) {
+                    int cell = r * gridCols + c;
+                    for (int k = this->workspace.cellStart[cell]; k < this->workspace.cellStart[cell + 1]; k++) {
+                        int j = this->workspace.cellEntries[k];
+                        if (j <= i || this->workspace.lastVisitedBy[j] == i) {
+                            continue;
+                        }
+                        this->workspace.lastVisitedBy[j] = i;
+                        if (distanceBetweenRects(box, boundingBoxes[j]) < threshold) {
+                            this->workspace.mergePairs.push_back(std::make_pair(i, j));
+                        }
+                    }
+                }
+            }
+            
+            // Keep the pairs in the same order as checking every pair would produce them.
+            std::sort(this->workspace.mergePairs.begin() + firstPair, this->workspace.mergePairs.end());
+        }
+    }
+    
+    int ContourFinder::findMergeSets(int numItems) {
+        this->workspace.mergeSets.Reset(numItems);
+        for (auto pair : this->workspace.mergePairs) {
+            this->workspace.mergeSets.Union(pair.first, pair.second);
         }
-        return minDist;
+        return this->workspace.mergeSets.CompactSetIds(this->workspace.mergeSetIds);
     }
     
     /**
      * Remove contours if they are are too small.
      */
     void ContourFinder::filterOutBadContours(std::vector<std::vector<cv::Point>>& contours) {
-        std::vector<double> areas(contours.size());
-        
-        // Find the area of each contour.
-        std::transform(contours.cbegin(),
-                       contours.cend(),
-                       areas.begin(),
-                       [](std::vector<cv::Point> contour) {
-                           return cv::contourArea(contour);
-                       });
-        
-        // Select the largest contour.
-        double maxArea = std::accumulate(areas.cbegin(),
-                                         areas.cend(),
-                                         0,
-                                         [](double prevMaxArea, double area) {
-                                             return std::max(prevMaxArea, area);
-                                         });
-        
-        // Create the threshold.
-        int threshold = this->contourSizeThreshold * maxArea;
+        // Select the largest contour. Its area was found along with its other statistics.
+        double maxArea = 0;
+        for (const auto& stats : this->workspace.blobs) {
+            maxArea = std::max(maxArea, stats.area);
+        }
         
         // Remove contours that have a size less than the threshold.
-        auto removeThese = std::remove_if(contours.begin(), contours.end(), [threshold](std::vector<cv::Point> contour) {
-            return cv::contourArea(contour) <= threshold;
+        int threshold = this->contourSizeThreshold * maxArea;
+        this->removeContours(contours, [threshold](const OT::BlobStats& stats) {
+            return stats.area <= threshold;
         });
-        contours.erase(removeThese, contours.end());
+    }
+    
+    template <typename Predicate>
+    void ContourFinder::removeContours(std::vector<std::vector<cv::Point>>& contours, Predicate shouldRemove) {
+        size_t numKept = 0;
+        for (size_t i = 0; i < contours.size(); i++) {
+            if (shouldRemove(this->workspace.blobs[i])) {
+                continue;
+            }
+            if (numKept != i) {
+                contours[numKept].swap(contours[i]);
+                this->workspace.blobs[numKept] = this->workspace.blobs[i];
+            }
+            numKept++;
+        }
+        contours.resize(numKept);
+        this->workspace.blobs.resize(numKept);
     }
     
     void ContourFinder::findContours(const cv::Mat& frame,
@@ -101,127 +199,179 @@ namespace OT {
         
         // Get rid little specks of noise by doing a median blur.
         // The median blur is good for salt-and-pepper noise, not Gaussian noise.
-        cv::medianBlur(this->foreground, this->foreground, this->medianFilterSize);
+        // Filtering into a separate buffer (rather than in place) saves OpenCV a copy.
+        cv::medianBlur(this->foreground, this->workspace.filtered, this->medianFilterSize);
+        
+        // Dilate the image to make the blobs larger (four times with a 3x3 kernel).
+        cv::dilate(this->workspace.filtered, this->foreground, cv::Mat(), cv::Point(-1, -1), 4);
         
-        // Dilate the image to make the blobs larger.
-        cv::dilate(this->foreground, this->foreground, cv::Mat());
-        cv::dilate(this->foreground, this->foreground, cv::Mat());
-        cv::dilate(this->foreground, this->foreground, cv::Mat());
-        cv::dilate(this->foreground, this->foreground, cv::Mat());
+        if (!this->headless) {
+            cv::imshow("foreground", this->foreground);
+        }
         
-        cv::imshow("foreground", this->foreground);
+        // Use connected component labeling if we've been asked to.
+        if (this->connectedComponents) {
+            this->findBlobs(massCenters, boundingBoxes);
+        } else {
+            this->findContourBlobs(hierarchy, contours, massCenters, boundingBoxes);
+        }
         
+        // Record whether any of the buffers had to grow for this frame (workspaceBytes is
+        // only zero before the first frame).
+        size_t bytes = this->workspace.reservedBytes() + this->labeler.reservedBytes();
+        if (this->workspaceBytes != 0 && bytes > this->workspaceBytes) {
+            this->numBufferGrowths++;
+        }
+        this->workspaceBytes = std::max(this->workspaceBytes, bytes);
+    }
+    
+    void ContourFinder::findContourBlobs(std::vector<cv::Vec4i>& hierarchy,
+                                         std::vector<std::vector<cv::Point>>& contours,
+                                         std::vector<cv::Point2f>& massCenters,
+                                         std::vector<cv::Rect>& boundingBoxes) {
         // Find the contours.
         cv::findContours(this->foreground, contours, hierarchy, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE, cv::Point(0, 0));
         
+        // Find the area, mass center, and bounding box of every contour once.
+        this->getContourStats(contours, this->workspace.blobs);
+        
         // Keep only those contours that are sufficiently large.
         this->filterOutBadContours(contours);
         
-        // Get the mass centers and bounding boxes.
-        this->getCentersAndBoundingBoxes(contours, massCenters, boundingBoxes);
-        
         // Remove any mass centers that appear in the suppressed rectangles.
-        this->suppressMassCenters(contours, massCenters, boundingBoxes);
+        this->suppressMassCenters(contours);
         
-        // Merge nearby contours.
-        this->mergeContours(contours, massCenters, boundingBoxes);
+        // Merge nearby contours. Only their statistics are merged, the contours are left alone.
+        this->mergeBlobs(this->workspace.blobs);
         
-        // Now find the mass centers and bounding boxes again.
-        this->getCentersAndBoundingBoxes(contours, massCenters, boundingBoxes);
+        // Get the mass centers and bounding boxes of the merged contours.
+        this->getCentersAndBoundingBoxes(this->workspace.blobs, massCenters, boundingBoxes);
     }
     
-    void ContourFinder::mergeContours(std::vector<std::vector<cv::Point> > &contours,
-                                      const std::vector<cv::Point2f>& massCenters,
-                                      const std::vector<cv::Rect>& boundingBoxes) {
-        DisjointSets sets(contours.size());
-        for (size_t i = 0; i < contours.size(); i++) {
-            for (size_t j = i + 1; j < contours.size(); j++) {
-                // Measure the distance between the mass centers,
-                // and if it's small enough, merge them.
-                if (distanceBetweenRects(boundingBoxes[i], boundingBoxes[j]) <
-                    this->contourMergeThreshold * this->diagonal) {
-                    sets.Union(i, j);
-                }
-            }
-        }
-        
-        // Create a map such that the values are the sets of
-        // indices of contours that should be merged.
-        std::unordered_map<int, std::vector<int>> itemsForSet;
+    void ContourFinder::getContourStats(const std::vector<std::vector<cv::Point>>& contours,
+                                        std::vector<OT::BlobStats>& blobs) {
+        blobs.resize(contours.size());
         for (size_t i = 0; i < contours.size(); i++) {
-            if (itemsForSet.find(sets.FindSet(i)) == itemsForSet.end()) {
-                itemsForSet.insert(std::pair<int, std::vector<int>>(sets.FindSet(i), std::vector<int>()));
-            }
-            itemsForSet[sets.FindSet(i)].push_back(i);
-        }
-        
-        // Now merge the contours.
-        std::vector<std::vector<cv::Point>> newContours;
-        for (auto kv : itemsForSet) {
-            // If there's only one item, just add it without doing any merge.
-            if (kv.second.size() == 1) {
-                newContours.push_back(contours[kv.first]);
-                continue;
-            }
+            // The moments give the area and the center of mass.
+            cv::Moments contourMoments = cv::moments(contours[i], false);
             
-            // Combine all the points of every contour
-            // that must be merged into the vector<vector<Point>> aggregate.
-            auto aggregate = contours[kv.second[0]];
-            for (size_t i = 1; i < kv.second.size(); i++) {
-                std::copy(contours[kv.second[i]].cbegin(),
-                          contours[kv.second[i]].cend(),
-                          std::back_inserter(aggregate));
-            }
+            // Compute the polygon represented by the contour, and then compute the bounding box around that polygon.
+            cv::approxPolyDP(contours[i], this->workspace.contourPolygon, 3, true);
+            cv::Rect box = cv::boundingRect(this->workspace.contourPolygon);
             
-            // Now use the merged contours instead of the original contours.
-            newContours.push_back(aggregate);
+            blobs[i].area = contourMoments.m00;
+            blobs[i].sumX = contourMoments.m10;
+            blobs[i].sumY = contourMoments.m01;
+            blobs[i].minX = box.x;
+            blobs[i].minY = box.y;
+            blobs[i].maxX = box.x + box.width - 1;
+            blobs[i].maxY = box.y + box.height - 1;
         }
-        
-        // Replace the old contours with the new ones.
-        contours.clear();
-        std::copy(newContours.cbegin(), newContours.cend(), std::back_inserter(contours));
     }
     
-    void ContourFinder::getCentersAndBoundingBoxes(const std::vector<std::vector<cv::Point> > &contours,
-                                                   std::vector<cv::Point2f> &massCenters,
-                                                   std::vector<cv::Rect> &boundingBoxes) {
-        // Empty the vectors.
-        massCenters.clear();
-        boundingBoxes.clear();
+    void ContourFinder::suppressRectangle(cv::Rect rect) {
+        this->suppressRectangles.push_back(rect);
+    }
+    
+    void ContourFinder::setHeadless(bool headless) {
+        this->headless = headless;
+    }
+    
+    void ContourFinder::setConnectedComponents(bool connectedComponents) {
+        this->connectedComponents = connectedComponents;
+    }
+    
+    long ContourFinder::bufferGrowths() const {
+        return this->numBufferGrowths;
+    }
+    
+    void ContourFinder::findBlobs(std::vector<cv::Point2f>& massCenters,
+                                  std::vector<cv::Rect>& boundingBoxes) {
+        // Find the blobs and their statistics in one pass.
+        this->labeler.label(this->foreground, this->workspace.blobs);
         
-        // Create local variables.
-        cv::Moments contourMoments;
-        std::vector<std::vector<cv::Point> > contourPolygons(contours.size());
+        // Keep only those blobs that are sufficiently large.
+        this->filterOutBadBlobs(this->workspace.blobs);
         
-        // Iterate through every contour.
-        for (size_t i = 0; i < contours.size(); i++) {
-            // Compute the center of mass.
-            contourMoments = cv::moments(contours[i], false);
-            massCenters.push_back(cv::Point2f(contourMoments.m10/contourMoments.m00, contourMoments.m01/contourMoments.m00));
-            
-            // Compute the polygon represented by the contour, and then compute the bounding box around that polygon.
-            cv::approxPolyDP(cv::Mat(contours[i]), contourPolygons[i], 3, true);
-            boundingBoxes.push_back(cv::boundingRect(cv::Mat(contourPolygons[i])));
+        // Remove any blobs whose mass centers appear in the suppressed rectangles.
+        this->suppressBlobs(this->workspace.blobs);
+        
+        // Merge nearby blobs.
+        this->mergeBlobs(this->workspace.blobs);
+        
+        // Get the mass centers and bounding boxes.
+        this->getCentersAndBoundingBoxes(this->workspace.blobs, massCenters, boundingBoxes);
+    }
+    
+    void ContourFinder::filterOutBadBlobs(std::vector<OT::BlobStats>& blobs) {
+        // Select the largest blob.
+        double maxArea = 0;
+        for (const auto& blob : blobs) {
+            maxArea = std::max(maxArea, blob.area);
         }
+        
+        // Remove blobs that have a size less than the threshold.
+        int threshold = this->contourSizeThreshold * maxArea;
+        auto removeThese = std::remove_if(blobs.begin(), blobs.end(), [threshold](const OT::BlobStats& blob) {
+            return blob.area <= threshold;
+        });
+        blobs.erase(removeThese, blobs.end());
     }
     
-    void ContourFinder::suppressRectangle(cv::Rect rect) {
-        this->suppressRectangles.push_back(rect);
+    bool ContourFinder::isSuppressed(const OT::BlobStats& blob) const {
+        cv::Point2f massCenter = blob.massCenter();
+        for (const auto& rect : this->suppressRectangles) {
+            if (rect.contains(massCenter)) {
+                return true;
+            }
+        }
+        return false;
     }
     
-    void ContourFinder::suppressMassCenters(std::vector<std::vector<cv::Point> > &contours,
-                                            std::vector<cv::Point2f> &massCenters,
-                                            std::vector<cv::Rect> &boundingBoxes) {
-        for (size_t i = 0; i < contours.size(); i++) {
-            for (size_t j = 0; j < this->suppressRectangles.size(); j++) {
-                if (this->suppressRectangles[j].contains(massCenters[i])) {
-                    contours.erase(contours.begin() + i);
-                    massCenters.erase(massCenters.begin() + i);
-                    boundingBoxes.erase(boundingBoxes.begin() + i);
-                    i--;
-                    break;
-                }
+    void ContourFinder::suppressBlobs(std::vector<OT::BlobStats>& blobs) {
+        auto removeThese = std::remove_if(blobs.begin(), blobs.end(), [this](const OT::BlobStats& blob) {
+            return this->isSuppressed(blob);
+        });
+        blobs.erase(removeThese, blobs.end());
+    }
+    
+    void ContourFinder::mergeBlobs(std::vector<OT::BlobStats>& blobs) {
+        // Find the sets of blobs that are close together, like we do for contours.
+        this->workspace.blobBoxes.clear();
+        for (const auto& blob : blobs) {
+            this->workspace.blobBoxes.push_back(blob.boundingBox());
+        }
+        this->findMergePairs(this->workspace.blobBoxes);
+        int numSets = this->findMergeSets((int) blobs.size());
+        
+        // Fold each blob into the first blob of its set. Sets are numbered in order of their
+        // first blob, so set k always lands in slot k, which has already been read.
+        int numKept = 0;
+        for (size_t i = 0; i < blobs.size(); i++) {
+            int set = this->workspace.mergeSetIds[i];
+            if (set == numKept) {
+                blobs[numKept++] = blobs[i];
+            } else {
+                blobs[set].merge(blobs[i]);
             }
         }
+        blobs.resize(numSets);
+    }
+    
+    void ContourFinder::getCentersAndBoundingBoxes(const std::vector<OT::BlobStats>& blobs,
+                                                   std::vector<cv::Point2f>& massCenters,
+                                                   std::vector<cv::Rect>& boundingBoxes) {
+        massCenters.clear();
+        boundingBoxes.clear();
+        for (const auto& blob : blobs) {
+            massCenters.push_back(blob.massCenter());
+            boundingBoxes.push_back(blob.boundingBox());
+        }
+    }
+    
+    void ContourFinder::suppressMassCenters(std::vector<std::vector<cv::Point> > &contours) {
+        this->removeContours(contours, [this](const OT::BlobStats& stats) {
+            return this->isSuppressed(stats);
+        });
     }
 }
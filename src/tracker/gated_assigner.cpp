@@ -0,0 +1,191 @@
+#include "tracker/gated_assigner.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+namespace OT {
+    /**
+     * Solves each stripe of components on its own thread.
+     */
+    class ComponentSolvingBody : public cv::ParallelLoopBody {
+    private:
+        GatedAssigner& assigner;
+        int numStripes;
+    public:
+        ComponentSolvingBody(GatedAssigner& assigner, int numStripes) :
+        assigner(assigner), numStripes(numStripes) {
+        }
+        
+        virtual void operator()(const cv::Range& range) const {
+            size_t numLarge = this->assigner.largeComponents.size();
+            for (int s = range.start; s < range.end; s++) {
+                size_t start = numLarge * s / this->numStripes;
+                size_t end = numLarge * (s + 1) / this->numStripes;
+                for (size_t k = start; k < end; k++) {
+                    this->assigner.solveComponent(this->assigner.largeComponents[k], *this->assigner.stripes[s]);
+                }
+            }
+        }
+    };
+    
+    GatedAssigner::GatedAssigner(AssignmentProblemSolver::TMethod method, int minParallelComponents) {
+        this->method = method;
+        this->minParallelComponents = minParallelComponents;
+        this->numRows = 0;
+        this->numColumns = 0;
+    }
+    
+    void GatedAssigner::reset(int numRows, int numColumns) {
+        this->numRows = numRows;
+        this->numColumns = numColumns;
+        this->pairs.clear();
+    }
+    
+    void GatedAssigner::allow(int row, int column, double cost) {
+        this->pairs.push_back(Pair{row, column, cost});
+    }
+    
+    int GatedAssigner::groupByComponent() {
+        // Join each row with the columns it may be assigned to.
+        int numElements = this->numRows + this->numColumns;
+        this->components.Reset(numElements);
+        for (const auto& pair : this->pairs) {
+            this->components.Union(pair.row, this->numRows + pair.column);
+        }
+        int numComponents = this->components.CompactSetIds(this->componentIds);
+        
+        // Count the rows, columns, and pairs of each component.
+        this->rowStart.assign(numComponents + 1, 0);
+        this->columnStart.assign(numComponents + 1, 0);
+        this->pairStart.assign(numComponents + 1, 0);
+        for (int row = 0; row < this->numRows; row++) {
+            this->rowStart[this->componentIds[row] + 1]++;
+        }
+        for (int column = 0; column < this->numColumns; column++) {
+            this->columnStart[this->componentIds[this->numRows + column] + 1]++;
+        }
+        for (const auto& pair : this->pairs) {
+            this->pairStart[this->componentIds[pair.row] + 1]++;
+        }
+        for (int c = 0; c < numComponents; c++) {
+            this->rowStart[c + 1] += this->rowStart[c];
+            this->columnStart[c + 1] += this->columnStart[c];
+            this->pairStart[c + 1] += this->pairStart[c];
+        }
+        
+        // Put them in order of component. The row and column indices within a component are
+        // their positions in that component's part of the arrays.
+        this->componentRows.resize(this->numRows);
+        this->componentColumns.resize(this->numColumns);
+        this->componentPairs.resize(this->pairs.size());
+        this->localIndex.resize(numElements);
+        this->cursor.assign(this->rowStart.begin(), this->rowStart.end() - 1);
+        for (int row = 0; row < this->numRows; row++) {
+            int c = this->componentIds[row];
+            this->localIndex[row] = this->cursor[c] - this->rowStart[c];
+            this->componentRows[this->cursor[c]++] = row;
+        }
+        this->cursor.assign(this->columnStart.begin(), this->columnStart.end() - 1);
+        for (int column = 0; column < this->numColumns; column++) {
+            int c = this->componentIds[this->numRows + column];
+            this->localIndex[this->numRows + column] = this->cursor[c] - this->columnStart[c];
+            this->componentColumns[this->cursor[c]++] = column;
+        }
+        this->cursor.assign(this->pairStart.begin(), this->pairStart.end() - 1);
+        for (int k = 0; k < (int) this->pairs.size(); k++) {
+            int c = this->componentIds[this->pairs[k].row];
+            this->componentPairs[this->cursor[c]++] = k;
+        }
+        return numComponents;
+    }
+    
+    void GatedAssigner::solveComponent(int c, Stripe& stripe) {
+        int numLocalRows = this->rowStart[c + 1] - this->rowStart[c];
+        int numLocalColumns = this->columnStart[c + 1] - this->columnStart[c];
+        
+        // Any assignment that only uses allowed pairs costs less than one forbidden pair.
+        double forbiddenCost = 1;
+        for (int k = this->pairStart[c]; k < this->pairStart[c + 1]; k++) {
+            forbiddenCost += this->pairs[this->componentPairs[k]].cost;
+        }
+        
+        // Build the dense problem of the component.
+        auto& costs = stripe.costs;
+        costs.assign(numLocalRows * numLocalColumns, forbiddenCost);
+        for (int k = this->pairStart[c]; k < this->pairStart[c + 1]; k++) {
+            const Pair& pair = this->pairs[this->componentPairs[k]];
+            costs[this->localIndex[pair.row] * numLocalColumns + this->localIndex[this->numRows + pair.column]] = pair.cost;
+        }
+        
+        this->solver.Solve(costs.data(), numLocalRows, numLocalColumns, numLocalColumns,
+                           stripe.assignment, stripe.workspace, this->method);
+        
+        // Keep the assignments to allowed pairs.
+        for (int i = 0; i < numLocalRows; i++) {
+            int j = stripe.assignment[i];
+            if (j >= 0 && costs[i * numLocalColumns + j] < forbiddenCost) {
+                this->rowAssignment[this->componentRows[this->rowStart[c] + i]] = this->componentColumns[this->columnStart[c] + j];
+            }
+        }
+    }
+    
+    int GatedAssigner::solve(std::vector<int>& assignment) {
+        this->rowAssignment.assign(this->numRows, -1);
+        int numComponents = this->groupByComponent();
+        
+        // A component with a single pair is just that assignment. The rest need a solver.
+        int numComponentsWithPairs = 0;
+        this->largeComponents.clear();
+        for (int c = 0; c < numComponents; c++) {
+            int numPairs = this->pairStart[c + 1] - this->pairStart[c];
+            if (numPairs == 0) {
+                continue;
+            }
+            numComponentsWithPairs++;
+            if (numPairs == 1) {
+                const Pair& pair = this->pairs[this->componentPairs[this->pairStart[c]]];
+                this->rowAssignment[pair.row] = pair.column;
+            } else {
+                this->largeComponents.push_back(c);
+            }
+        }
+        
+        // Solve the rest, splitting them into one stripe per thread if there are enough of them.
+        int numLarge = (int) this->largeComponents.size();
+        int numStripes = 1;
+        if (numLarge >= this->minParallelComponents) {
+            numStripes = std::max(1, std::min(cv::getNumThreads(), numLarge));
+        }
+        while ((int) this->stripes.size() < numStripes) {
+            this->stripes.push_back(std::unique_ptr<Stripe>(new Stripe()));
+        }
+        if (numStripes > 1) {
+            cv::parallel_for_(cv::Range(0, numStripes), ComponentSolvingBody(*this, numStripes));
+        } else {
+            for (int c : this->largeComponents) {
+                this->solveComponent(c, *this->stripes[0]);
+            }
+        }
+        
+        assignment.assign(this->rowAssignment.begin(), this->rowAssignment.end());
+        return numComponentsWithPairs;
+    }
+    
+    size_t GatedAssigner::reservedBytes() const {
+        size_t bytes = this->pairs.capacity() * sizeof(Pair);
+        bytes += this->components.ReservedBytes() + this->componentIds.capacity() * sizeof(int);
+        bytes += (this->rowStart.capacity() + this->columnStart.capacity() + this->pairStart.capacity()) * sizeof(int);
+        bytes += (this->componentRows.capacity() + this->componentColumns.capacity()
+                  + this->componentPairs.capacity() + this->localIndex.capacity()) * sizeof(int);
+        bytes += (this->cursor.capacity() + this->largeComponents.capacity() + this->rowAssignment.capacity()) * sizeof(int);
+        bytes += this->solver.reservedBytes() + this->stripes.capacity() * sizeof(std::unique_ptr<Stripe>);
+        for (const auto& stripe : this->stripes) {
+            bytes += sizeof(Stripe) + stripe->workspace.reservedBytes();
+            bytes += stripe->costs.capacity() * sizeof(double) + stripe->assignment.capacity() * sizeof(int);
+        }
+        return bytes;
+    }
+}
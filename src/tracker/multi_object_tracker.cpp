@@ -1,12 +1,16 @@
 #include "tracker/multi_object_tracker.hpp"
 
+#include <cmath>
 #include <memory>
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <string>
 
 #include <opencv2/opencv.hpp>
 
-#include "tracker/kalman_tracker.hpp"
+#include "tracker/tracking_output.hpp"
 #include "lib/hungarian.hpp"
 
 namespace OT {
@@ -18,8 +22,10 @@ namespace OT {
                                            float magnitudeOfAccelerationNoise,
                                            int lifetimeSuppressionThreshold,
                                            float distanceSuppressionThreshold,
-                                           float ageSuppressionThreshold) {
-        this->kalmanTrackers = std::vector<OT::KalmanTracker>();
+                                           float ageSuppressionThreshold,
+                                           Association association,
+                                           double auctionTolerance) {
+        this->kalmanTrackers = OT::TrackerBank(dt, magnitudeOfAccelerationNoise);
         this->frameSize = frameSize;
         this->lifetimeThreshold = lifetimeThreshold;
         this->distanceThreshold = distanceThreshold;
@@ -29,188 +35,544 @@ namespace OT {
         this->distanceSuppressionThreshold = distanceSuppressionThreshold;
         this->ageSuppressionThreshold = ageSuppressionThreshold;
         this->dt = dt;
+        cv::Point framePoint = cv::Point(frameSize.width, frameSize.height);
+        this->frameDiagonal = std::sqrt(framePoint.dot(framePoint));
+        this->suppressionReach = (int) std::ceil(distanceSuppressionThreshold * this->frameDiagonal) + 1;
+        this->costStride = 0;
+        this->association = association;
+        this->cascade = false;
+        this->associationSeconds = 0;
+        this->numAugmentedRows = 0;
+        this->scratchBytes = 0;
+        this->numScratchGrowths = 0;
+        
+        // In auction association, each tracker's mass center may be this much further (as a
+        // fraction of the frame diagonal) than the best one for it at the final prices.
+        this->solver.SetAuctionTolerance(auctionTolerance);
     }
     
     void MultiObjectTracker::update(const std::vector<cv::Point2f>& massCenters,
                                     const std::vector<cv::Rect>& boundingRects,
                                     std::vector<OT::TrackingOutput>& trackingOutputs) {
+        this->update(massCenters, boundingRects, massCenters.size(), trackingOutputs);
+    }
+    
+    void MultiObjectTracker::update(const std::vector<cv::Point2f>& massCenters,
+                                    const std::vector<cv::Rect>& boundingRects,
+                                    size_t numStarting,
+                                    std::vector<OT::TrackingOutput>& trackingOutputs) {
         trackingOutputs.clear();
         
         // If we haven't found any mass centers, just update all the Kalman filters and return their predictions.
         if (massCenters.empty()) {
-            for (int i = 0; i < this->kalmanTrackers.size(); i++) {
+            this->shouldRemove.assign(this->kalmanTrackers.size(), 0);
+            for (size_t i = 0; i < this->kalmanTrackers.size(); i++) {
                 // Indicate that the tracker didn't get an update this frame.
-                this->kalmanTrackers[i].noUpdateThisFrame();
+                this->kalmanTrackers.noUpdateThisFrame(i);
                 
                 // Remove the tracker if it is dead.
-                if (this->kalmanTrackers[i].getNumFramesWithoutUpdate() > this->missedFramesThreshold) {
-                    this->kalmanTrackers.erase(this->kalmanTrackers.begin() + i);
-                    i--;
-                }
+                this->shouldRemove[i] = this->kalmanTrackers.getNumFramesWithoutUpdate(i) > this->missedFramesThreshold;
             }
+            this->kalmanTrackers.removeIf(this->shouldRemove);
+            
             // Update the remaining trackers.
+            this->shouldPredict.resize(this->kalmanTrackers.size());
             for (size_t i = 0; i < this->kalmanTrackers.size(); i++) {
-                if (this->kalmanTrackers[i].getLifetime() > lifetimeThreshold) {
-                    this->kalmanTrackers[i].predict();
-                    trackingOutputs.push_back(this->kalmanTrackers[i].latestTrackingOutput());
-                }
+                this->shouldPredict[i] = this->kalmanTrackers.getLifetime(i) > lifetimeThreshold;
             }
+            this->kalmanTrackers.predict(this->shouldPredict);
+            this->kalmanTrackers.latestTrackingOutputs(this->lifetimeThreshold, trackingOutputs);
+            this->recordScratchGrowth();
             return;
         }
         
-        // If there are no Kalman trackers, make one for each detection.
+        // If there are no Kalman trackers, make one for each detection that can start one.
         if (this->kalmanTrackers.empty()) {
-            for (auto massCenter : massCenters) {
-                this->kalmanTrackers.push_back(OT::KalmanTracker(massCenter,
-                                                                 this->dt,
-                                                                 this->magnitudeOfAccelerationNoise));
+            for (size_t j = 0; j < std::min(numStarting, massCenters.size()); j++) {
+                this->kalmanTrackers.add(massCenters[j]);
             }
         }
         
-        // Create our cost matrix.
         size_t numKalmans = this->kalmanTrackers.size();
         size_t numCenters = massCenters.size();
         
-        std::vector<std::vector<double>> costMatrix(numKalmans, std::vector<double>(numCenters));
-    
-        std::vector<int> assignment;
-        
-        
-        // Get the latest prediction for the Kalman filters.
-        std::vector<cv::Point2f> predictions(this->kalmanTrackers.size());
-        for (size_t i = 0; i < this->kalmanTrackers.size(); i++) {
-            predictions[i] = this->kalmanTrackers[i].latestPrediction();
+        // Get the latest prediction for the Kalman filters, and find the bounding boxes they're in.
+        this->predictions.resize(numKalmans);
+        for (size_t i = 0; i < numKalmans; i++) {
+            this->predictions[i] = this->kalmanTrackers.latestPrediction(i);
         }
+        this->findContainingRects(boundingRects);
         
-        // We need to associate each of the mass centers to their corresponding Kalman filter. First,
-        // let's find the pairwise distances. However, we first divide this distance by the diagonal size
-        // of the frame to ensure that it is between 0 and 1.
-        cv::Point framePoint = cv::Point(this->frameSize.width, this->frameSize.height);
-        double frameDiagonal = std::sqrt(framePoint.dot(framePoint));
-        for (size_t i = 0; i < predictions.size(); i++) {
-            for (size_t j = 0; j < massCenters.size(); j++) {
-                costMatrix[i][j] = cv::norm(predictions[i] - massCenters[j]) / frameDiagonal;
+        // Associate each of the mass centers to their corresponding Kalman filter. With the
+        // cascade, the association only gets the trackers and mass centers it didn't match.
+        auto associationStart = std::chrono::steady_clock::now();
+        if (this->cascade && boundingRects.size() == numCenters) {
+            this->matchContained(massCenters);
+            this->associate(this->solverMassCenters);
+            for (size_t k = 0; k < this->assignment.size(); k++) {
+                if (this->assignment[k] != -1) {
+                    this->cascadeAssignment[this->solverTrackers[k]] = this->solverCenters[this->assignment[k]];
+                }
             }
+            this->assignment.swap(this->cascadeAssignment);
+        } else {
+            this->solverTrackers.resize(numKalmans);
+            std::iota(this->solverTrackers.begin(), this->solverTrackers.end(), 0);
+            this->associate(massCenters);
         }
+        this->associationSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - associationStart).count();
         
-        // Assign Kalman trackers to mass centers with the Hungarian algorithm.
-        AssignmentProblemSolver solver;
-        solver.Solve(costMatrix, assignment, AssignmentProblemSolver::optimal);
+        // If a Kalman tracker is contained in a bounding box and shares its
+        // bounding box with another tracker, mark it as updated.
+        this->markSharedBoundingRects();
         
-        // Unassign any Kalman trackers whose distance to their assignment is too large.
-        std::vector<int> kalmansWithoutCenters;
-        for (size_t i = 0; i < assignment.size(); i++) {
-            if (assignment[i] != -1) {
-                if (costMatrix[i][assignment[i]] > this->distanceThreshold) {
-                    assignment[i] = -1;
-                    kalmansWithoutCenters.push_back(i);
-                }
+        // Remove any trackers that haven't been updated in a while, along with their assignments.
+        this->shouldRemove.assign(numKalmans, 0);
+        size_t numKept = 0;
+        for (size_t i = 0; i < numKalmans; i++) {
+            if (this->kalmanTrackers.getNumFramesWithoutUpdate(i) > this->missedFramesThreshold) {
+                this->shouldRemove[i] = 1;
             } else {
-                this->kalmanTrackers[i].noUpdateThisFrame();
+                this->assignment[numKept++] = this->assignment[i];
             }
         }
+        this->assignment.resize(numKept);
+        this->kalmanTrackers.removeIf(this->shouldRemove);
         
-        // If a Kalman tracker is contained in a bounding box and shares its
-        // bounding box with another tracker, remove its assignment and mark it
-        // as updated.
-        for (size_t i = 0; i < assignment.size(); i++) {
-            for (size_t j = 0; j < boundingRects.size(); j++) {
-                if (boundingRects[j].contains(this->kalmanTrackers[i].latestPrediction())
-                    && this->sharesBoundingRect(i, boundingRects[j])) {
-                    this->kalmanTrackers[i].gotUpdate();
+        // Create new trackers for the unassigned mass centers that can start them.
+        this->centerIsAssigned.assign(numCenters, 0);
+        for (int center : this->assignment) {
+            if (center != -1) {
+                this->centerIsAssigned[center] = 1;
+            }
+        }
+        for (size_t j = 0; j < std::min(numStarting, numCenters); j++) {
+            if (!this->centerIsAssigned[j]) {
+                this->kalmanTrackers.add(massCenters[j]);
+            }
+        }
+        
+        // Update the Kalman filters. The new trackers (past the end of assignment) are left alone.
+        this->shouldPredict.assign(this->assignment.size(), 1);
+        this->kalmanTrackers.predict(this->shouldPredict);
+        this->kalmanTrackers.correct(this->assignment, massCenters);
+        for (size_t i = 0; i < this->assignment.size(); i++) {
+            if (this->assignment[i] != -1) {
+                this->kalmanTrackers.gotUpdate(i);
+            }
+        }
+        
+        // Remove any suppressed filters. A filter that is removed can't suppress the ones after it.
+        this->indexTrackers();
+        this->shouldRemove.assign(this->kalmanTrackers.size(), 0);
+        for (size_t i = 0; i < this->kalmanTrackers.size(); i++) {
+            this->shouldRemove[i] = this->hasSuppressor(i);
+        }
+        this->kalmanTrackers.removeIf(this->shouldRemove);
+        
+        // Now update the predictions.
+        this->kalmanTrackers.latestTrackingOutputs(this->lifetimeThreshold, trackingOutputs);
+        this->recordScratchGrowth();
+    }
+    
+    void MultiObjectTracker::fillCostMatrix(const std::vector<cv::Point2f>& massCenters, size_t numRows, size_t stride) {
+        size_t numKalmans = this->predictions.size();
+        size_t numCenters = massCenters.size();
+        this->costStride = stride;
+        this->costMatrix.assign(numRows * stride, 0);
+        
+        // First, let's find the pairwise distances. However, we first divide this distance by the
+        // diagonal size of the frame to ensure that it is between 0 and 1.
+        for (size_t i = 0; i < numKalmans; i++) {
+            double* row = &this->costMatrix[i * stride];
+            for (size_t j = 0; j < numCenters; j++) {
+                row[j] = cv::norm(this->predictions[i] - massCenters[j]) / this->frameDiagonal;
+            }
+        }
+    }
+    
+    void MultiObjectTracker::matchContained(const std::vector<cv::Point2f>& massCenters) {
+        size_t numKalmans = this->predictions.size();
+        size_t numCenters = massCenters.size();
+        this->cascadeAssignment.assign(numKalmans, -1);
+        this->cascadeMatched.assign(numCenters, 0);
+        for (size_t r = 0; r < numCenters; r++) {
+            // Find the oldest tracker in the bounding box, as long as none of them are in
+            // another one.
+            int oldest = -1;
+            bool isTied = false;
+            bool isContested = false;
+            for (int k = this->rectStart[r]; k < this->rectStart[r + 1]; k++) {
+                int i = this->rectTrackers[k];
+                if (this->trackerRectCount[i] != 1) {
+                    isContested = true;
                     break;
                 }
+                if (oldest == -1 || this->kalmanTrackers.getLifetime(i) > this->kalmanTrackers.getLifetime(oldest)) {
+                    oldest = i;
+                    isTied = false;
+                } else if (this->kalmanTrackers.getLifetime(i) == this->kalmanTrackers.getLifetime(oldest)) {
+                    isTied = true;
+                }
+            }
+            if (oldest == -1 || isTied || isContested) {
+                continue;
+            }
+            
+            if (cv::norm(this->predictions[oldest] - massCenters[r]) / this->frameDiagonal <= this->distanceThreshold) {
+                this->cascadeAssignment[oldest] = (int) r;
+                this->cascadeMatched[r] = 1;
+                
+                // The incremental association starts it on its closest mass center next frame.
+                this->kalmanTrackers.setPreviousMatch(oldest, OT::TrackerBank::matchedMassCenter, 0);
             }
         }
         
-        // Remove any trackers that haven't been updated in a while.
-        for (int i = 0; i < this->kalmanTrackers.size(); i++) {
-            if (this->kalmanTrackers[i].getNumFramesWithoutUpdate() > this->missedFramesThreshold) {
-                this->kalmanTrackers.erase(this->kalmanTrackers.begin() + i);
-                assignment.erase(assignment.begin() + i);
-                i--;
+        // Gather the trackers and mass centers that are left.
+        this->solverTrackers.clear();
+        for (size_t i = 0; i < numKalmans; i++) {
+            if (this->cascadeAssignment[i] == -1) {
+                this->predictions[this->solverTrackers.size()] = this->predictions[i];
+                this->solverTrackers.push_back((int) i);
+            }
+        }
+        this->predictions.resize(this->solverTrackers.size());
+        this->solverCenters.clear();
+        this->solverMassCenters.clear();
+        for (size_t j = 0; j < numCenters; j++) {
+            if (!this->cascadeMatched[j]) {
+                this->solverCenters.push_back((int) j);
+                this->solverMassCenters.push_back(massCenters[j]);
+            }
+        }
+    }
+    
+    void MultiObjectTracker::associate(const std::vector<cv::Point2f>& massCenters) {
+        // There's nothing to solve if the cascade matched every tracker or every mass center.
+        if (this->predictions.empty() || massCenters.empty()) {
+            this->assignment.assign(this->predictions.size(), -1);
+            this->markUnassigned();
+            return;
+        }
+        switch (this->association) {
+            case dense: this->assignDense(massCenters); break;
+            case gated: this->assignGated(massCenters); break;
+            case incremental: this->assignIncremental(massCenters); break;
+            case auction: this->assignDense(massCenters, AssignmentProblemSolver::auction); break;
+        }
+    }
+    
+    void MultiObjectTracker::dropDistantAssignments() {
+        // Unassign any Kalman trackers whose distance to their assignment is too large.
+        for (size_t i = 0; i < this->assignment.size(); i++) {
+            if (this->assignment[i] != -1) {
+                if (this->costMatrix[i * this->costStride + this->assignment[i]] > this->distanceThreshold) {
+                    this->assignment[i] = -1;
+                }
+            } else {
+                this->kalmanTrackers.noUpdateThisFrame(this->solverTrackers[i]);
+            }
+        }
+    }
+    
+    void MultiObjectTracker::markUnassigned() {
+        for (size_t i = 0; i < this->assignment.size(); i++) {
+            if (this->assignment[i] == -1) {
+                this->kalmanTrackers.noUpdateThisFrame(this->solverTrackers[i]);
             }
         }
+    }
+    
+    void MultiObjectTracker::assignDense(const std::vector<cv::Point2f>& massCenters,
+                                         AssignmentProblemSolver::TMethod method) {
+        size_t numKalmans = this->predictions.size();
+        size_t numCenters = massCenters.size();
+        this->fillCostMatrix(massCenters, numKalmans, numCenters);
         
-        // Find unassigned mass centers.
-        std::vector<int> centersWithoutKalman;
-        std::vector<int>::iterator it;
-        for (size_t i = 0; i < massCenters.size(); i++) {
-            it = std::find(assignment.begin(), assignment.end(), i);
-            if (it == assignment.end()) {
-                centersWithoutKalman.push_back(i);
+        // Assign Kalman trackers to mass centers with the Hungarian algorithm.
+        this->solver.Solve(this->costMatrix.data(), numKalmans, numCenters, numCenters,
+                           this->assignment, this->workspace, method);
+        this->dropDistantAssignments();
+    }
+    
+    void MultiObjectTracker::assignGated(const std::vector<cv::Point2f>& massCenters) {
+        // Only the pairs within the distance threshold are given to the solver.
+        size_t numKalmans = this->predictions.size();
+        size_t numCenters = massCenters.size();
+        double maxOffset = this->distanceThreshold * this->frameDiagonal;
+        this->gatedAssigner.reset(numKalmans, numCenters);
+        for (size_t i = 0; i < numKalmans; i++) {
+            for (size_t j = 0; j < numCenters; j++) {
+                cv::Point2f offset = this->predictions[i] - massCenters[j];
+                if (std::abs(offset.x) > maxOffset || std::abs(offset.y) > maxOffset) {
+                    continue;
+                }
+                double cost = cv::norm(offset) / this->frameDiagonal;
+                if (cost <= this->distanceThreshold) {
+                    this->gatedAssigner.allow(i, j, cost);
+                }
             }
         }
+        this->gatedAssigner.solve(this->assignment);
         
-        // Create new trackers for the unassigned mass centers.
-        for (size_t i = 0; i < centersWithoutKalman.size(); i++) {
-            this->kalmanTrackers.push_back(OT::KalmanTracker(massCenters[centersWithoutKalman[i]]));
+        // Every tracker left without a mass center missed this frame.
+        this->markUnassigned();
+    }
+    
+    void MultiObjectTracker::assignIncremental(const std::vector<cv::Point2f>& massCenters) {
+        // Pad the problem to a square with zero cost rows (if there are more mass centers) or
+        // columns (if there are more trackers), which stand for not being matched.
+        size_t numKalmans = this->predictions.size();
+        size_t numCenters = massCenters.size();
+        size_t n = std::max(numKalmans, numCenters);
+        if (n == 0) {
+            this->assignment.clear();
+            return;
         }
+        this->fillCostMatrix(massCenters, n, n);
+        const std::vector<double>& squareCosts = this->costMatrix;
         
-        // Update the Kalman filters.
-        for (size_t i = 0; i < assignment.size(); i++) {
-            this->kalmanTrackers[i].predict();
-            if (assignment[i] != -1) {
-                this->kalmanTrackers[i].correct(massCenters[assignment[i]]);
-                this->kalmanTrackers[i].gotUpdate();
+        // Start each tracker on the mass center closest to it, or on the next padding column if
+        // it didn't get a mass center last frame, at the price its match had last frame.
+        this->squareAssignment.assign(n, -1);
+        this->columnPrices.resize(n);
+        this->startedColumns.assign(n, 0);
+        this->startingSlack.resize(numKalmans);
+        size_t nextPaddingColumn = numCenters;
+        for (size_t i = 0; i < numKalmans; i++) {
+            size_t j = n;
+            int tracker = this->solverTrackers[i];
+            if (this->kalmanTrackers.getPreviousMatch(tracker) == OT::TrackerBank::matchedMassCenter) {
+                const double* row = &squareCosts[i * n];
+                j = std::min_element(row, row + numCenters) - row;
+            } else if (this->kalmanTrackers.getPreviousMatch(tracker) == OT::TrackerBank::matchedNothing
+                       && nextPaddingColumn < n) {
+                j = nextPaddingColumn++;
+            }
+            if (j == n || this->startedColumns[j]) {
+                continue;
             }
+            this->startedColumns[j] = 1;
+            this->squareAssignment[i] = j;
+            this->columnPrices[j] = this->kalmanTrackers.getPreviousPrice(tracker);
+            this->startingSlack[i] = squareCosts[i * n + j] - this->columnPrices[j];
         }
         
-        // Remove any suppressed filters.
-        for (size_t i = 0; i < this->kalmanTrackers.size(); i++) {
-            if (this->hasSuppressor(i)) {
-                this->kalmanTrackers.erase(this->kalmanTrackers.begin() + i);
-                i--;
+        // Price every other column so that it's no cheaper than the starting column for any
+        // started tracker. If there are none, price it at its smallest cost.
+        for (size_t j = 0; j < n; j++) {
+            if (this->startedColumns[j]) {
+                continue;
+            }
+            bool hasPrice = false;
+            double price = 0;
+            for (size_t i = 0; i < numKalmans; i++) {
+                if (this->squareAssignment[i] != -1) {
+                    double slackPrice = squareCosts[i * n + j] - this->startingSlack[i];
+                    if (!hasPrice || slackPrice < price) {
+                        price = slackPrice;
+                        hasPrice = true;
+                    }
+                }
+            }
+            if (!hasPrice) {
+                price = squareCosts[j];
+                for (size_t i = 1; i < n; i++) {
+                    price = std::min(price, squareCosts[i * n + j]);
+                }
             }
+            this->columnPrices[j] = price;
         }
         
-        // Now update the predictions.
+        // Repair the starting solution with augmenting paths.
+        this->numAugmentedRows += this->solver.SolveWarm(squareCosts.data(), n, this->columnPrices,
+                                                         this->squareAssignment, this->workspace);
+        
+        // Prices only matter relative to each other, so keep them from drifting over time.
+        double maxPrice = *std::max_element(this->columnPrices.begin(), this->columnPrices.end());
+        
+        // Remember the matches for next frame, and drop the padding.
+        this->assignment.resize(numKalmans);
+        for (size_t i = 0; i < numKalmans; i++) {
+            int j = this->squareAssignment[i];
+            bool matchedMassCenter = j < (int) numCenters;
+            this->kalmanTrackers.setPreviousMatch(this->solverTrackers[i],
+                                                  matchedMassCenter ? OT::TrackerBank::matchedMassCenter : OT::TrackerBank::matchedNothing,
+                                                  this->columnPrices[j] - maxPrice);
+            this->assignment[i] = matchedMassCenter ? j : -1;
+        }
+        this->dropDistantAssignments();
+    }
+    
+    void MultiObjectTracker::setAssociation(Association association) {
+        this->association = association;
+    }
+    
+    bool MultiObjectTracker::setAssociation(const std::string& name) {
+        if (name == "dense") {
+            this->association = dense;
+        } else if (name == "gated") {
+            this->association = gated;
+        } else if (name == "incremental") {
+            this->association = incremental;
+        } else if (name == "auction") {
+            this->association = auction;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    
+    void MultiObjectTracker::setCascade(bool cascade) {
+        this->cascade = cascade;
+    }
+    
+    void MultiObjectTracker::setMinParallelTrackers(size_t minParallelTrackers) {
+        this->kalmanTrackers.setMinParallelTrackers(minParallelTrackers);
+    }
+    
+    int MultiObjectTracker::handOver(int id, MultiObjectTracker& destination) {
         for (size_t i = 0; i < this->kalmanTrackers.size(); i++) {
-            if (this->kalmanTrackers[i].getLifetime() > this->lifetimeThreshold) {
-                trackingOutputs.push_back(this->kalmanTrackers[i].latestTrackingOutput());
+            if (this->kalmanTrackers.getId(i) == id) {
+                // The destination drops the trackers it started for the object before it arrived.
+                destination.suppressUnreported(this->kalmanTrackers.latestPrediction(i), this->kalmanTrackers.getLifetime(i));
+                int newId = destination.kalmanTrackers.addCopy(this->kalmanTrackers, i);
+                this->shouldRemove.assign(this->kalmanTrackers.size(), 0);
+                this->shouldRemove[i] = 1;
+                this->kalmanTrackers.removeIf(this->shouldRemove);
+                return newId;
             }
         }
+        return -1;
     }
     
-    bool MultiObjectTracker::sharesBoundingRect(size_t i, cv::Rect boundingRect) {
+    void MultiObjectTracker::suppressUnreported(const cv::Point& position, long lifetime) {
+        this->shouldRemove.assign(this->kalmanTrackers.size(), 0);
         for (size_t j = 0; j < this->kalmanTrackers.size(); j++) {
-            if (i == j) {
+            long otherLifetime = this->kalmanTrackers.getLifetime(j);
+            if (otherLifetime > this->lifetimeThreshold || lifetime < this->ageSuppressionThreshold * otherLifetime) {
                 continue;
             }
-            if (boundingRect.contains(this->kalmanTrackers[i].latestPrediction())) {
-                return true;
+            double dist = cv::norm(position - this->kalmanTrackers.latestPrediction(j));
+            this->shouldRemove[j] = dist / this->frameDiagonal <= this->distanceSuppressionThreshold;
+        }
+        this->kalmanTrackers.removeIf(this->shouldRemove);
+    }
+    
+    void MultiObjectTracker::allTrackingOutputs(std::vector<OT::TrackingOutput>& outputs) {
+        outputs.clear();
+        this->kalmanTrackers.latestTrackingOutputs(-1, outputs);
+    }
+    
+    double MultiObjectTracker::suppressionDistance() const {
+        return this->distanceSuppressionThreshold * this->frameDiagonal;
+    }
+    
+    double MultiObjectTracker::associationGate() const {
+        return this->distanceThreshold * this->frameDiagonal;
+    }
+    
+    double MultiObjectTracker::associationTime() const {
+        return this->associationSeconds;
+    }
+    
+    long MultiObjectTracker::augmentedRows() const {
+        return this->numAugmentedRows;
+    }
+    
+    size_t MultiObjectTracker::reservedBytes() const {
+        size_t bytes = this->kalmanTrackers.reservedBytes() + this->solver.reservedBytes();
+        bytes += this->gatedAssigner.reservedBytes();
+        bytes += (this->columnPrices.capacity() + this->startingSlack.capacity()) * sizeof(double);
+        bytes += this->squareAssignment.capacity() * sizeof(int) + this->startedColumns.capacity();
+        bytes += this->workspace.reservedBytes() + this->costMatrix.capacity() * sizeof(double);
+        bytes += this->assignment.capacity() * sizeof(int) + this->predictions.capacity() * sizeof(cv::Point2f);
+        bytes += this->shouldPredict.capacity() + this->shouldRemove.capacity() + this->centerIsAssigned.capacity();
+        bytes += this->trackerPositions.capacity() * sizeof(cv::Point) + this->trackerGrid.reservedBytes();
+        bytes += (this->rectStart.capacity() + this->rectTrackers.capacity() + this->trackerRectCount.capacity()) * sizeof(int);
+        bytes += this->sharesRect.capacity() + this->cascadeMatched.capacity();
+        bytes += (this->solverTrackers.capacity() + this->solverCenters.capacity() + this->cascadeAssignment.capacity()) * sizeof(int);
+        bytes += this->solverMassCenters.capacity() * sizeof(cv::Point2f);
+        return bytes;
+    }
+    
+    void MultiObjectTracker::recordScratchGrowth() {
+        // scratchBytes is only zero before the first frame.
+        size_t bytes = this->reservedBytes();
+        if (this->scratchBytes != 0 && bytes > this->scratchBytes) {
+            this->numScratchGrowths++;
+        }
+        this->scratchBytes = std::max(this->scratchBytes, bytes);
+    }
+    
+    long MultiObjectTracker::scratchGrowths() const {
+        return this->numScratchGrowths;
+    }
+    
+    void MultiObjectTracker::indexTrackers() {
+        this->trackerPositions.resize(this->kalmanTrackers.size());
+        for (size_t i = 0; i < this->kalmanTrackers.size(); i++) {
+            this->trackerPositions[i] = this->kalmanTrackers.latestPrediction(i);
+        }
+        this->trackerGrid.build(this->trackerPositions, this->suppressionReach);
+    }
+    
+    void MultiObjectTracker::findContainingRects(const std::vector<cv::Rect>& boundingRects) {
+        this->indexTrackers();
+        this->rectStart.resize(boundingRects.size() + 1);
+        this->rectTrackers.clear();
+        this->trackerRectCount.assign(this->kalmanTrackers.size(), 0);
+        for (size_t r = 0; r < boundingRects.size(); r++) {
+            this->rectStart[r] = (int) this->rectTrackers.size();
+            this->trackerGrid.anyInRect(boundingRects[r], [this](int i) {
+                this->rectTrackers.push_back(i);
+                this->trackerRectCount[i]++;
+                return false;
+            });
+        }
+        this->rectStart[boundingRects.size()] = (int) this->rectTrackers.size();
+    }
+    
+    void MultiObjectTracker::markSharedBoundingRects() {
+        // Flag the trackers in every rectangle that has more than one, then update each flagged
+        // tracker once.
+        this->sharesRect.assign(this->kalmanTrackers.size(), 0);
+        for (size_t r = 0; r + 1 < this->rectStart.size(); r++) {
+            if (this->rectStart[r + 1] - this->rectStart[r] > 1) {
+                for (int k = this->rectStart[r]; k < this->rectStart[r + 1]; k++) {
+                    this->sharesRect[this->rectTrackers[k]] = 1;
+                }
+            }
+        }
+        for (size_t i = 0; i < this->kalmanTrackers.size(); i++) {
+            if (this->sharesRect[i]) {
+                this->kalmanTrackers.gotUpdate(i);
             }
         }
-        return false;
     }
     
     bool MultiObjectTracker::hasSuppressor(size_t i) {
-        double dist;
-        cv::Point framePoint = cv::Point(this->frameSize.width, this->frameSize.height);
-        double frameDiagonal = std::sqrt(framePoint.dot(framePoint));
+        long lifetime = this->kalmanTrackers.getLifetime(i);
+        if (lifetime >= this->lifetimeSuppressionThreshold) {
+            return false;
+        }
         
-        for (size_t j = 0; j < this->kalmanTrackers.size(); j++) {
-            if (i == j) {
-                continue;
+        // Only the trackers within the suppression distance (give or take rounding) can suppress it.
+        cv::Point position = this->trackerPositions[i];
+        cv::Rect neighborhood(position.x - this->suppressionReach,
+                              position.y - this->suppressionReach,
+                              2 * this->suppressionReach + 1,
+                              2 * this->suppressionReach + 1);
+        return this->trackerGrid.anyInRect(neighborhood, [this, i, lifetime, position](int j) {
+            if ((size_t) j == i || this->shouldRemove[j]) {
+                return false;
             }
-            
-            if (this->kalmanTrackers[i].getLifetime() >= this->lifetimeSuppressionThreshold) {
-                continue;
-            }
-            
-            if (this->kalmanTrackers[j].getLifetime() <
-                this->ageSuppressionThreshold * this->kalmanTrackers[i].getLifetime()) {
-                continue;
+            if (this->kalmanTrackers.getLifetime(j) < this->ageSuppressionThreshold * lifetime) {
+                return false;
             }
-            
-            dist = cv::norm(this->kalmanTrackers[i].latestPrediction()
-                            - this->kalmanTrackers[j].latestPrediction());
-            dist /= frameDiagonal;
-            
-            if (dist <= this->distanceSuppressionThreshold) {
-                return true;
-            }
-        }
-        return false;
+            double dist = cv::norm(position - this->trackerPositions[j]);
+            dist /= this->frameDiagonal;
+            return dist <= this->distanceSuppressionThreshold;
+        });
     }
 }
@@ -0,0 +1,354 @@
+#include "tracker/partitioned_tracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+namespace OT {
+    /**
+     * Updates a range of zones, each on its own.
+     */
+    class ZoneUpdatingBody : public cv::ParallelLoopBody {
+    private:
+        PartitionedTracker& partitioned;
+    public:
+        ZoneUpdatingBody(PartitionedTracker& partitioned) : partitioned(partitioned) {
+        }
+        
+        virtual void operator()(const cv::Range& range) const {
+            for (int z = range.start; z < range.end; z++) {
+                PartitionedTracker::Zone& zone = *this->partitioned.zones[z];
+                for (const auto& suppressor : zone.suppressors) {
+                    zone.tracker.suppressUnreported(suppressor.location, suppressor.lifetime);
+                }
+                zone.tracker.update(zone.massCenters, zone.boundingRects, zone.numCoreCenters, zone.outputs);
+                zone.tracker.allTrackingOutputs(zone.trackers);
+            }
+        }
+    };
+    
+    PartitionedTracker::PartitionedTracker(cv::Size frameSize,
+                                           int numZoneColumns,
+                                           int numZoneRows,
+                                           int overlap) {
+        this->frameSize = frameSize;
+        this->numZoneColumns = std::max(numZoneColumns, 1);
+        this->numZoneRows = std::max(numZoneRows, 1);
+        this->overlap = std::max(overlap, 0);
+        this->nextGlobalId = 0;
+        for (int z = 0; z < this->numZoneColumns * this->numZoneRows; z++) {
+            this->zones.push_back(std::unique_ptr<Zone>(new Zone(frameSize)));
+        }
+        this->handoffDistance = this->zones[0]->tracker.associationGate();
+        this->suppressionDistance = this->zones[0]->tracker.suppressionDistance();
+    }
+    
+    int PartitionedTracker::zoneColumn(float x) const {
+        int column = (int) std::floor(x * this->numZoneColumns / this->frameSize.width);
+        return std::min(std::max(column, 0), this->numZoneColumns - 1);
+    }
+    
+    int PartitionedTracker::zoneRow(float y) const {
+        int row = (int) std::floor(y * this->numZoneRows / this->frameSize.height);
+        return std::min(std::max(row, 0), this->numZoneRows - 1);
+    }
+    
+    int PartitionedTracker::zoneIndex(const cv::Point2f& point) const {
+        return this->zoneRow(point.y) * this->numZoneColumns + this->zoneColumn(point.x);
+    }
+    
+    bool PartitionedTracker::isInBand(const cv::Point& point, int zone) const {
+        int row = zone / this->numZoneColumns;
+        int column = zone % this->numZoneColumns;
+        return this->zoneColumn(point.x - this->overlap) <= column && column <= this->zoneColumn(point.x + this->overlap)
+            && this->zoneRow(point.y - this->overlap) <= row && row <= this->zoneRow(point.y + this->overlap);
+    }
+    
+    const cv::Point& PartitionedTracker::location(const ZoneTrack& track) const {
+        return this->zones[track.zone]->outputs[track.output].location;
+    }
+    
+    void PartitionedTracker::distribute(const std::vector<cv::Point2f>& massCenters,
+                                        const std::vector<cv::Rect>& boundingRects) {
+        for (auto& zone : this->zones) {
+            zone->massCenters.clear();
+            zone->boundingRects.clear();
+        }
+        
+        // Each zone gets the mass centers in its core first, since only those can start trackers
+        // in it (otherwise two zones would follow the objects near their border).
+        for (size_t j = 0; j < massCenters.size(); j++) {
+            Zone& zone = *this->zones[this->zoneIndex(massCenters[j])];
+            zone.massCenters.push_back(massCenters[j]);
+            zone.boundingRects.push_back(boundingRects[j]);
+        }
+        for (auto& zone : this->zones) {
+            zone->numCoreCenters = zone->massCenters.size();
+        }
+        
+        // A mass center is also in the band of every other zone whose core is within overlap of it.
+        for (size_t j = 0; j < massCenters.size(); j++) {
+            const cv::Point2f& massCenter = massCenters[j];
+            int core = this->zoneIndex(massCenter);
+            int firstColumn = this->zoneColumn(massCenter.x - this->overlap);
+            int lastColumn = this->zoneColumn(massCenter.x + this->overlap);
+            int firstRow = this->zoneRow(massCenter.y - this->overlap);
+            int lastRow = this->zoneRow(massCenter.y + this->overlap);
+            for (int row = firstRow; row <= lastRow; row++) {
+                for (int column = firstColumn; column <= lastColumn; column++) {
+                    if (row * this->numZoneColumns + column == core) {
+                        continue;
+                    }
+                    Zone& zone = *this->zones[row * this->numZoneColumns + column];
+                    zone.massCenters.push_back(massCenter);
+                    zone.boundingRects.push_back(boundingRects[j]);
+                }
+            }
+        }
+    }
+    
+    void PartitionedTracker::linkTracks() {
+        // Look up the global ID of every output.
+        this->tracks.clear();
+        this->unlinkedTracks.clear();
+        for (int z = 0; z < (int) this->zones.size(); z++) {
+            const Zone& zone = *this->zones[z];
+            for (int k = 0; k < (int) zone.outputs.size(); k++) {
+                auto link = this->findLink(zone, zone.outputs[k].id);
+                if (link != zone.links.end()) {
+                    this->tracks.push_back(ZoneTrack{link->globalId, z, k, link->isReporting});
+                } else {
+                    this->unlinkedTracks.push_back(ZoneTrack{-1, z, k, false});
+                }
+            }
+        }
+        
+        // A track that handed its ID to another zone's track takes it back if that track is gone.
+        this->isReported.assign(this->nextGlobalId, 0);
+        for (const auto& track : this->tracks) {
+            if (track.isReporting) {
+                this->isReported[track.globalId] = 1;
+            }
+        }
+        for (auto& track : this->tracks) {
+            if (!track.isReporting && !this->isReported[track.globalId]) {
+                track.isReporting = true;
+                this->isReported[track.globalId] = 1;
+            }
+        }
+        
+        // A track that has crossed into the core of another zone is handed off. If that zone has
+        // its own track close to it (which it started while the object was in its core before, or
+        // which handed the ID over), that track is following the same object and takes over
+        // the ID, and the track that crossed keeps it without reporting it. Otherwise the
+        // tracker moves.
+        this->handoffs.clear();
+        size_t numLinked = this->tracks.size();
+        for (size_t t = 0; t < numLinked; t++) {
+            ZoneTrack& track = this->tracks[t];
+            if (!track.isReporting) {
+                continue;
+            }
+            int destination = this->zoneIndex(this->location(track));
+            if (destination == track.zone) {
+                continue;
+            }
+            ZoneTrack* twin = this->closestTwin(track, destination);
+            if (twin != nullptr) {
+                twin->globalId = track.globalId;
+                twin->isReporting = true;
+                track.isReporting = false;
+            } else {
+                int localId = this->zones[track.zone]->outputs[track.output].id;
+                this->handoffs.push_back(Handoff{track.zone, localId, destination});
+            }
+        }
+        
+        // A track without an ID in its zone's core that's within overlap of a track the zone can
+        // see in another zone is probably following the same object (it started before that
+        // track's zone started following it), and is left alone until that object crosses over.
+        // Anything else in a zone's core is a new object. The rest are left alone.
+        for (auto& unlinked : this->unlinkedTracks) {
+            if (unlinked.globalId != -1) {
+                this->tracks.push_back(unlinked);
+                continue;
+            }
+            const cv::Point& location = this->location(unlinked);
+            if (this->zoneIndex(location) != unlinked.zone) {
+                continue;
+            }
+            bool hasTwin = false;
+            for (size_t t = 0; t < numLinked && !hasTwin; t++) {
+                const ZoneTrack& track = this->tracks[t];
+                hasTwin = track.isReporting
+                    && track.zone != unlinked.zone
+                    && this->isInBand(this->location(track), unlinked.zone)
+                    && cv::norm(location - this->location(track)) <= this->overlap;
+            }
+            if (!hasTwin) {
+                unlinked.globalId = this->nextGlobalId++;
+                unlinked.isReporting = true;
+                this->tracks.push_back(unlinked);
+            }
+        }
+        
+        // Only keep the links of the tracks that are still around (a zone tracker's mature
+        // trackers are in its outputs every frame until they're removed).
+        for (auto& zone : this->zones) {
+            zone->links.clear();
+        }
+        for (const auto& track : this->tracks) {
+            Zone& zone = *this->zones[track.zone];
+            zone.links.push_back(Link{zone.outputs[track.output].id, track.globalId, track.isReporting});
+        }
+        for (auto& zone : this->zones) {
+            std::sort(zone->links.begin(), zone->links.end(),
+                      [](const Link& a, const Link& b) { return a.localId < b.localId; });
+        }
+        
+        // The trackers without an ID move to the zone whose core they're in too, so that they
+        // aren't lost when their object leaves the band.
+        for (int z = 0; z < (int) this->zones.size(); z++) {
+            const Zone& zone = *this->zones[z];
+            for (const auto& tracker : zone.trackers) {
+                int destination = this->zoneIndex(tracker.location);
+                if (destination != z && this->findLink(zone, tracker.id) == zone.links.end()) {
+                    this->handoffs.push_back(Handoff{z, tracker.id, destination});
+                }
+            }
+        }
+    }
+    
+    std::vector<PartitionedTracker::Link>::const_iterator PartitionedTracker::findLink(const Zone& zone, int localId) const {
+        auto link = std::lower_bound(zone.links.begin(), zone.links.end(), localId,
+                                     [](const Link& a, int id) { return a.localId < id; });
+        return link != zone.links.end() && link->localId == localId ? link : zone.links.end();
+    }
+    
+    PartitionedTracker::ZoneTrack* PartitionedTracker::closestTwin(const ZoneTrack& track, int zone) {
+        const cv::Point& location = this->location(track);
+        ZoneTrack* closest = nullptr;
+        double closestDistance = this->handoffDistance;
+        auto consider = [&](ZoneTrack& candidate) {
+            double distance = cv::norm(location - this->location(candidate));
+            if (distance <= closestDistance) {
+                closest = &candidate;
+                closestDistance = distance;
+            }
+        };
+        for (auto& unlinked : this->unlinkedTracks) {
+            if (unlinked.zone == zone && unlinked.globalId == -1) {
+                consider(unlinked);
+            }
+        }
+        for (auto& other : this->tracks) {
+            if (other.zone == zone && other.globalId == track.globalId && !other.isReporting) {
+                consider(other);
+            }
+        }
+        return closest;
+    }
+    
+    void PartitionedTracker::moveTrackers() {
+        for (const auto& handoff : this->handoffs) {
+            Zone& zone = *this->zones[handoff.zone];
+            Zone& destination = *this->zones[handoff.destination];
+            auto link = this->findLink(zone, handoff.localId);
+            int newId = zone.tracker.handOver(handoff.localId, destination.tracker);
+            
+            // The new ID is the largest in the destination, so its links stay sorted.
+            if (link != zone.links.end()) {
+                destination.links.push_back(Link{newId, link->globalId, true});
+                zone.links.erase(link);
+            }
+        }
+        this->handoffs.clear();
+    }
+    
+    void PartitionedTracker::findSuppressors() {
+        for (auto& zone : this->zones) {
+            zone->suppressors.clear();
+        }
+        // Only the trackers in a zone's core can suppress, since the ones in its band are following
+        // objects that the zone whose core they're in has its own trackers for. Trackers that were
+        // just created can only suppress the ones in later zones, or two of them on either side of
+        // a border would remove each other (a single tracker only lets the first one suppress).
+        double reach = this->overlap + this->suppressionDistance;
+        for (int source = 0; source < (int) this->zones.size(); source++) {
+            for (const auto& tracker : this->zones[source]->trackers) {
+                if (this->zoneIndex(tracker.location) != source) {
+                    continue;
+                }
+                int firstColumn = this->zoneColumn(tracker.location.x - reach);
+                int lastColumn = this->zoneColumn(tracker.location.x + reach);
+                int firstRow = this->zoneRow(tracker.location.y - reach);
+                int lastRow = this->zoneRow(tracker.location.y + reach);
+                for (int row = firstRow; row <= lastRow; row++) {
+                    for (int column = firstColumn; column <= lastColumn; column++) {
+                        int z = row * this->numZoneColumns + column;
+                        if (z > source || (z < source && tracker.lifetime > 0)) {
+                            this->zones[z]->suppressors.push_back(Suppressor{tracker.location, tracker.lifetime});
+                        }
+                    }
+                }
+            }
+        }
+    }
+    
+    void PartitionedTracker::update(const std::vector<cv::Point2f>& massCenters,
+                                    const std::vector<cv::Rect>& boundingRects,
+                                    std::vector<OT::TrackingOutput>& trackingOutputs) {
+        // The trackers are moved (and the zones' young trackers suppressed) now, rather than at
+        // the end of the last update, so that the last outputs stayed valid until this update
+        // like a MultiObjectTracker's.
+        this->moveTrackers();
+        this->distribute(massCenters, boundingRects);
+        cv::parallel_for_(cv::Range(0, (int) this->zones.size()), ZoneUpdatingBody(*this));
+        this->linkTracks();
+        this->findSuppressors();
+        
+        trackingOutputs.clear();
+        for (const auto& track : this->tracks) {
+            if (track.isReporting) {
+                trackingOutputs.push_back(this->zones[track.zone]->outputs[track.output]);
+                trackingOutputs.back().id = track.globalId;
+            }
+        }
+    }
+    
+    bool PartitionedTracker::setAssociation(const std::string& name) {
+        for (auto& zone : this->zones) {
+            if (!zone->tracker.setAssociation(name)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    void PartitionedTracker::setCascade(bool cascade) {
+        for (auto& zone : this->zones) {
+            zone->tracker.setCascade(cascade);
+        }
+    }
+    
+    void PartitionedTracker::setMinParallelTrackers(size_t minParallelTrackers) {
+        for (auto& zone : this->zones) {
+            zone->tracker.setMinParallelTrackers(minParallelTrackers);
+        }
+    }
+    
+    double PartitionedTracker::associationTime() const {
+        double seconds = 0;
+        for (const auto& zone : this->zones) {
+            seconds += zone->tracker.associationTime();
+        }
+        return seconds;
+    }
+    
+    int PartitionedTracker::numZones() const {
+        return (int) this->zones.size();
+    }
+}
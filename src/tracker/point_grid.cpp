@@ -0,0 +1,83 @@
+#include "tracker/point_grid.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+namespace OT {
+    PointGrid::PointGrid() {
+        this->cellSize = 1;
+        this->numCellColumns = 0;
+        this->numCellRows = 0;
+    }
+    
+    int PointGrid::cellColumn(int x) const {
+        if (x < this->origin.x) {
+            return 0;
+        }
+        return std::min((x - this->origin.x) / this->cellSize, this->numCellColumns - 1);
+    }
+    
+    int PointGrid::cellRow(int y) const {
+        if (y < this->origin.y) {
+            return 0;
+        }
+        return std::min((y - this->origin.y) / this->cellSize, this->numCellRows - 1);
+    }
+    
+    void PointGrid::build(const std::vector<cv::Point>& points, int cellSize) {
+        this->points.assign(points.begin(), points.end());
+        this->cellStart.assign(1, 0);
+        this->cellPoints.resize(points.size());
+        this->numCellColumns = 0;
+        this->numCellRows = 0;
+        if (points.empty()) {
+            return;
+        }
+        
+        // Cover the bounding box of the points, with at most a few cells per point.
+        cv::Point lowest = points[0];
+        cv::Point highest = points[0];
+        for (const auto& point : points) {
+            lowest.x = std::min(lowest.x, point.x);
+            lowest.y = std::min(lowest.y, point.y);
+            highest.x = std::max(highest.x, point.x);
+            highest.y = std::max(highest.y, point.y);
+        }
+        this->origin = lowest;
+        this->cellSize = std::max(cellSize, 1);
+        while (true) {
+            this->numCellColumns = (highest.x - lowest.x) / this->cellSize + 1;
+            this->numCellRows = (highest.y - lowest.y) / this->cellSize + 1;
+            if ((long) this->numCellColumns * this->numCellRows <= 4 * (long) points.size()) {
+                break;
+            }
+            this->cellSize *= 2;
+        }
+        
+        // Count the points in each cell, and turn the counts into the end of each cell's
+        // points. Filling the cells from the back then leaves each count at its cell's start,
+        // with the points of a cell in the order they were given. Reserving for the most cells
+        // there can be keeps the counts from growing as the points spread out.
+        int numCells = this->numCellColumns * this->numCellRows;
+        this->cellStart.reserve(4 * points.size() + 1);
+        this->cellStart.assign(numCells + 1, 0);
+        for (const auto& point : points) {
+            this->cellStart[this->cellRow(point.y) * this->numCellColumns + this->cellColumn(point.x)]++;
+        }
+        for (int c = 1; c < numCells; c++) {
+            this->cellStart[c] += this->cellStart[c - 1];
+        }
+        this->cellStart[numCells] = (int) points.size();
+        for (int i = (int) points.size() - 1; i >= 0; i--) {
+            int c = this->cellRow(points[i].y) * this->numCellColumns + this->cellColumn(points[i].x);
+            this->cellPoints[--this->cellStart[c]] = i;
+        }
+    }
+    
+    size_t PointGrid::reservedBytes() const {
+        return this->points.capacity() * sizeof(cv::Point)
+            + (this->cellStart.capacity() + this->cellPoints.capacity()) * sizeof(int);
+    }
+}
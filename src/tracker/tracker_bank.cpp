@@ -0,0 +1,458 @@
+#include "tracker/tracker_bank.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+namespace OT {
+    constexpr float TrackerBank::steadyStateTolerance;
+    
+    // Remove the entries of values whose flag in shouldRemove is set, keeping the rest in order.
+    // The vector keeps its capacity.
+    template <typename T>
+    void removeFlagged(std::vector<T>& values, const std::vector<unsigned char>& shouldRemove) {
+        size_t kept = 0;
+        for (size_t i = 0; i < values.size(); i++) {
+            if (!shouldRemove[i]) {
+                if (kept != i) {
+                    values[kept] = std::move(values[i]);
+                }
+                kept++;
+            }
+        }
+        values.erase(values.begin() + kept, values.end());
+    }
+    
+    /**
+     * Calls a function on a range of trackers for each of the ranges it's given.
+     */
+    template <typename Function>
+    class RangeBody : public cv::ParallelLoopBody {
+    private:
+        size_t numTrackers;
+        int numRanges;
+        Function f;
+    public:
+        RangeBody(size_t numTrackers, int numRanges, Function f) :
+        numTrackers(numTrackers), numRanges(numRanges), f(f) {
+        }
+        
+        virtual void operator()(const cv::Range& range) const {
+            for (int r = range.start; r < range.end; r++) {
+                this->f(this->numTrackers * r / this->numRanges, this->numTrackers * (r + 1) / this->numRanges);
+            }
+        }
+    };
+    
+    TrackerBank::TrackerBank(float dt,
+                             float magnitudeOfAccelerationNoise,
+                             size_t maxTrajectorySize) {
+        CV_Assert(maxTrajectorySize <= OT::Trajectory::capacity);
+        
+        this->dt = dt;
+        this->magnitudeOfAccelerationNoise = magnitudeOfAccelerationNoise;
+        this->maxTrajectorySize = maxTrajectorySize;
+        this->measurementNoise = 0.1;
+        this->nextId = 0;
+        this->minParallelTrackers = 0;
+        
+        // The process noise of a constant velocity model with random acceleration.
+        this->processPosVar = (float) (std::pow(dt, 4.0) / 4.0) * magnitudeOfAccelerationNoise;
+        this->processPosVelCov = (float) (std::pow(dt, 3.0) / 2.0) * magnitudeOfAccelerationNoise;
+        this->processVelVar = (float) std::pow(dt, 2.0) * magnitudeOfAccelerationNoise;
+        
+        this->steadyState = findSteadyState(*this);
+    }
+    
+    const TrackerBank::SteadyState* TrackerBank::findSteadyState(const TrackerBank& bank) {
+        // The steady states of every configuration seen so far. Entries are never removed,
+        // so pointers to them stay valid.
+        static std::mutex mutex;
+        static std::map<std::tuple<float, float, float>, SteadyState> steadyStates;
+        
+        std::lock_guard<std::mutex> lock(mutex);
+        auto key = std::make_tuple(bank.dt, bank.magnitudeOfAccelerationNoise, bank.measurementNoise);
+        auto it = steadyStates.find(key);
+        if (it != steadyStates.end()) {
+            return &it->second;
+        }
+        
+        // Correct a tracker's covariance every frame until it stops changing (or only changes
+        // by rounding errors).
+        float tolerance = steadyStateTolerance / 100;
+        float posVar = 0.1, posVelCov = 0, velVar = 0.1;
+        float positionGain = 0, velocityGain = 0;
+        SteadyState steadyState;
+        steadyState.exists = false;
+        for (int i = 0; i < 10000 && !steadyState.exists; i++) {
+            float previousPosVar = posVar, previousPosVelCov = posVelCov, previousVelVar = velVar;
+            bank.predictCovariance(posVar, posVelCov, velVar);
+            steadyState.predictedPosVar = posVar;
+            steadyState.predictedPosVelCov = posVelCov;
+            steadyState.predictedVelVar = velVar;
+            bank.correctCovariance(posVar, posVelCov, velVar, positionGain, velocityGain);
+            steadyState.exists = (std::abs(posVar - previousPosVar) <= tolerance * posVar
+                                  && std::abs(posVelCov - previousPosVelCov) <= tolerance * std::abs(posVelCov)
+                                  && std::abs(velVar - previousVelVar) <= tolerance * velVar);
+        }
+        steadyState.correctedPosVar = posVar;
+        steadyState.correctedPosVelCov = posVelCov;
+        steadyState.correctedVelVar = velVar;
+        steadyState.positionGain = positionGain;
+        steadyState.velocityGain = velocityGain;
+        
+        return &steadyStates.insert(std::make_pair(key, steadyState)).first->second;
+    }
+    
+    void TrackerBank::predictCovariance(float& posVar, float& posVelCov, float& velVar) const {
+        // A * covariance * A^T + Q, where A adds dt times the velocity to the position.
+        float dt = this->dt;
+        float p00 = posVar + dt * (2 * posVelCov + dt * velVar) + this->processPosVar;
+        float p01 = posVelCov + dt * velVar + this->processPosVelCov;
+        float p11 = velVar + this->processVelVar;
+        posVar = p00;
+        posVelCov = p01;
+        velVar = p11;
+    }
+    
+    void TrackerBank::correctCovariance(float& posVar,
+                                        float& posVelCov,
+                                        float& velVar,
+                                        float& positionGain,
+                                        float& velocityGain) const {
+        // The gain is (posVar, posVelCov) / (posVar + measurementNoise), and the
+        // covariance becomes covariance - K * H * covariance.
+        float s = posVar + this->measurementNoise;
+        positionGain = posVar / s;
+        velocityGain = posVelCov / s;
+        float p00 = posVar;
+        float p01 = posVelCov;
+        posVar = p00 - positionGain * p00;
+        posVelCov = p01 - positionGain * p01;
+        velVar -= velocityGain * p01;
+    }
+    
+    size_t TrackerBank::size() const {
+        return this->x.size();
+    }
+    
+    bool TrackerBank::empty() const {
+        return this->x.empty();
+    }
+    
+    void TrackerBank::add(cv::Point startPt) {
+        // Take the next ID, and scramble it into a color so that trackers added one after
+        // another look different.
+        this->id.push_back(this->nextId++);
+        unsigned int hash = (unsigned int) this->id.back() * 2654435761u;
+        this->color.push_back(cv::Scalar((hash >> 8) & 255, (hash >> 16) & 255, hash >> 24));
+        
+        // Start at the given point, standing still.
+        this->x.push_back(startPt.x);
+        this->y.push_back(startPt.y);
+        this->vx.push_back(0);
+        this->vy.push_back(0);
+        this->posVar.push_back(0.1);
+        this->posVelCov.push_back(0);
+        this->velVar.push_back(0.1);
+        this->steadyStage.push_back(transient);
+        
+        this->numFramesWithoutUpdate.push_back(0);
+        this->lifetime.push_back(0);
+        this->prediction.push_back(startPt);
+        this->trajectory.push_back(OT::Trajectory(this->maxTrajectorySize));
+        this->previousMatch.push_back(noPreviousMatch);
+        this->previousPrice.push_back(0);
+    }
+    
+    int TrackerBank::addCopy(const TrackerBank& source, size_t i) {
+        this->id.push_back(this->nextId++);
+        this->color.push_back(source.color[i]);
+        
+        this->x.push_back(source.x[i]);
+        this->y.push_back(source.y[i]);
+        this->vx.push_back(source.vx[i]);
+        this->vy.push_back(source.vy[i]);
+        this->posVar.push_back(source.posVar[i]);
+        this->posVelCov.push_back(source.posVelCov[i]);
+        this->velVar.push_back(source.velVar[i]);
+        this->steadyStage.push_back(source.steadyStage[i]);
+        
+        this->numFramesWithoutUpdate.push_back(source.numFramesWithoutUpdate[i]);
+        this->lifetime.push_back(source.lifetime[i]);
+        this->prediction.push_back(source.prediction[i]);
+        this->trajectory.push_back(source.trajectory[i]);
+        
+        // Its last match was in the other bank's assignment.
+        this->previousMatch.push_back(noPreviousMatch);
+        this->previousPrice.push_back(0);
+        
+        return this->id.back();
+    }
+    
+    void TrackerBank::removeIf(const std::vector<unsigned char>& shouldRemove) {
+        removeFlagged(this->x, shouldRemove);
+        removeFlagged(this->y, shouldRemove);
+        removeFlagged(this->vx, shouldRemove);
+        removeFlagged(this->vy, shouldRemove);
+        removeFlagged(this->posVar, shouldRemove);
+        removeFlagged(this->posVelCov, shouldRemove);
+        removeFlagged(this->velVar, shouldRemove);
+        removeFlagged(this->steadyStage, shouldRemove);
+        removeFlagged(this->numFramesWithoutUpdate, shouldRemove);
+        removeFlagged(this->lifetime, shouldRemove);
+        removeFlagged(this->prediction, shouldRemove);
+        removeFlagged(this->id, shouldRemove);
+        removeFlagged(this->color, shouldRemove);
+        removeFlagged(this->trajectory, shouldRemove);
+        removeFlagged(this->previousMatch, shouldRemove);
+        removeFlagged(this->previousPrice, shouldRemove);
+    }
+    
+    size_t TrackerBank::reservedBytes() const {
+        size_t bytes = (this->x.capacity() + this->y.capacity() + this->vx.capacity() + this->vy.capacity()) * sizeof(float);
+        bytes += (this->posVar.capacity() + this->posVelCov.capacity() + this->velVar.capacity()) * sizeof(float);
+        bytes += this->steadyStage.capacity() * sizeof(SteadyStage);
+        bytes += this->numFramesWithoutUpdate.capacity() * sizeof(int) + this->lifetime.capacity() * sizeof(long);
+        bytes += this->prediction.capacity() * sizeof(cv::Point);
+        bytes += this->id.capacity() * sizeof(int) + this->color.capacity() * sizeof(cv::Scalar);
+        bytes += this->trajectory.capacity() * sizeof(OT::Trajectory);
+        bytes += this->previousMatch.capacity() + this->previousPrice.capacity() * sizeof(double);
+        bytes += (this->weight.capacity() + this->measuredX.capacity() + this->measuredY.capacity()
+                  + this->positionGain.capacity() + this->velocityGain.capacity()) * sizeof(float);
+        bytes += this->outputTrackers.capacity() * sizeof(int);
+        return bytes;
+    }
+    
+    template <typename Function>
+    void TrackerBank::forEachRange(size_t n, Function f) {
+        int numRanges = 1;
+        if (this->minParallelTrackers > 0 && n >= this->minParallelTrackers) {
+            numRanges = (int) std::min<size_t>(std::max(cv::getNumThreads(), 1), n);
+        }
+        if (numRanges > 1) {
+            cv::parallel_for_(cv::Range(0, numRanges), RangeBody<Function>(n, numRanges, f));
+        } else {
+            f(0, n);
+        }
+    }
+    
+    void TrackerBank::predict(const std::vector<unsigned char>& shouldPredict) {
+        size_t n = std::min(shouldPredict.size(), this->size());
+        this->weight.resize(n);
+        this->forEachRange(n, [this, &shouldPredict](size_t start, size_t end) {
+            this->predictRange(shouldPredict, start, end);
+        });
+    }
+    
+    void TrackerBank::predictRange(const std::vector<unsigned char>& shouldPredict, size_t start, size_t end) {
+        for (size_t i = start; i < end; i++) {
+            this->weight[i] = shouldPredict[i] ? 1 : 0;
+        }
+        
+        const float dt = this->dt;
+        const float* w = this->weight.data();
+        float* x = this->x.data();
+        float* y = this->y.data();
+        const float* vx = this->vx.data();
+        const float* vy = this->vy.data();
+        
+        // state = A * state, where A adds dt times the velocity to the position. Trackers with
+        // a weight of 0 don't change.
+        for (size_t i = start; i < end; i++) {
+            x[i] += w[i] * (dt * vx[i]);
+            y[i] += w[i] * (dt * vy[i]);
+        }
+        
+        // covariance = A * covariance * A^T + Q, unless the tracker is in the steady state.
+        for (size_t i = start; i < end; i++) {
+            if (!shouldPredict[i]) {
+                continue;
+            }
+            if (this->steadyStage[i] == corrected) {
+                this->posVar[i] = this->steadyState->predictedPosVar;
+                this->posVelCov[i] = this->steadyState->predictedPosVelCov;
+                this->velVar[i] = this->steadyState->predictedVelVar;
+                this->steadyStage[i] = predicted;
+            } else {
+                this->predictCovariance(this->posVar[i], this->posVelCov[i], this->velVar[i]);
+                this->steadyStage[i] = transient;
+            }
+        }
+        
+        // Record the predictions.
+        for (size_t i = start; i < end; i++) {
+            if (shouldPredict[i]) {
+                this->prediction[i] = cv::Point((int) x[i], (int) y[i]);
+                this->trajectory[i].push_back(this->prediction[i]);
+            }
+        }
+    }
+    
+    void TrackerBank::correct(const std::vector<int>& assignment, const std::vector<cv::Point2f>& massCenters) {
+        // Gather the measurements, so that the update itself is one loop over contiguous arrays.
+        // The measurements are whole pixels.
+        size_t n = std::min(assignment.size(), this->size());
+        this->measuredX.resize(n);
+        this->measuredY.resize(n);
+        this->positionGain.resize(n);
+        this->velocityGain.resize(n);
+        this->forEachRange(n, [this, &assignment, &massCenters](size_t start, size_t end) {
+            this->correctRange(assignment, massCenters, start, end);
+        });
+    }
+    
+    void TrackerBank::correctRange(const std::vector<int>& assignment,
+                                   const std::vector<cv::Point2f>& massCenters,
+                                   size_t start,
+                                   size_t end) {
+        for (size_t i = start; i < end; i++) {
+            if (assignment[i] != -1) {
+                cv::Point measurement = massCenters[assignment[i]];
+                this->measuredX[i] = measurement.x;
+                this->measuredY[i] = measurement.y;
+            } else {
+                this->measuredX[i] = this->x[i];
+                this->measuredY[i] = this->y[i];
+            }
+        }
+        
+        // Find the gains and update the covariances. Trackers without a measurement get a
+        // gain of 0, so they don't change.
+        for (size_t i = start; i < end; i++) {
+            if (assignment[i] == -1) {
+                this->positionGain[i] = 0;
+                this->velocityGain[i] = 0;
+            } else if (this->steadyStage[i] == predicted) {
+                this->positionGain[i] = this->steadyState->positionGain;
+                this->velocityGain[i] = this->steadyState->velocityGain;
+                this->posVar[i] = this->steadyState->correctedPosVar;
+                this->posVelCov[i] = this->steadyState->correctedPosVelCov;
+                this->velVar[i] = this->steadyState->correctedVelVar;
+                this->steadyStage[i] = corrected;
+            } else {
+                this->correctCovariance(this->posVar[i], this->posVelCov[i], this->velVar[i],
+                                        this->positionGain[i], this->velocityGain[i]);
+                this->steadyStage[i] = transient;
+                if (this->isNearSteadyState(i)) {
+                    this->posVar[i] = this->steadyState->correctedPosVar;
+                    this->posVelCov[i] = this->steadyState->correctedPosVelCov;
+                    this->velVar[i] = this->steadyState->correctedVelVar;
+                    this->steadyStage[i] = corrected;
+                }
+            }
+        }
+        
+        const float* zx = this->measuredX.data();
+        const float* zy = this->measuredY.data();
+        const float* k0 = this->positionGain.data();
+        const float* k1 = this->velocityGain.data();
+        float* x = this->x.data();
+        float* y = this->y.data();
+        float* vx = this->vx.data();
+        float* vy = this->vy.data();
+        
+        // state = state + K * (z - H * state).
+        for (size_t i = start; i < end; i++) {
+            float dx = zx[i] - x[i];
+            float dy = zy[i] - y[i];
+            x[i] += k0[i] * dx;
+            vx[i] += k1[i] * dx;
+            y[i] += k0[i] * dy;
+            vy[i] += k1[i] * dy;
+        }
+        
+        // The corrected states are the latest predictions.
+        for (size_t i = start; i < end; i++) {
+            if (assignment[i] != -1) {
+                this->prediction[i] = cv::Point((int) x[i], (int) y[i]);
+            }
+        }
+    }
+    
+    bool TrackerBank::isNearSteadyState(size_t i) const {
+        if (!this->steadyState->exists) {
+            return false;
+        }
+        float tolerance = steadyStateTolerance;
+        return (std::abs(this->posVar[i] - this->steadyState->correctedPosVar) <= tolerance * this->steadyState->correctedPosVar
+                && std::abs(this->posVelCov[i] - this->steadyState->correctedPosVelCov) <= tolerance * std::abs(this->steadyState->correctedPosVelCov)
+                && std::abs(this->velVar[i] - this->steadyState->correctedVelVar) <= tolerance * this->steadyState->correctedVelVar);
+    }
+    
+    void TrackerBank::noUpdateThisFrame(size_t i) {
+        this->lifetime[i]++;
+        this->numFramesWithoutUpdate[i]++;
+    }
+    
+    void TrackerBank::gotUpdate(size_t i) {
+        this->lifetime[i]++;
+        this->numFramesWithoutUpdate[i] = 0;
+    }
+    
+    int TrackerBank::getId(size_t i) const {
+        return this->id[i];
+    }
+    
+    int TrackerBank::getNumFramesWithoutUpdate(size_t i) const {
+        return this->numFramesWithoutUpdate[i];
+    }
+    
+    long TrackerBank::getLifetime(size_t i) const {
+        return this->lifetime[i];
+    }
+    
+    cv::Point TrackerBank::latestPrediction(size_t i) const {
+        return this->prediction[i];
+    }
+    
+    void TrackerBank::setPreviousMatch(size_t i, PreviousMatch match, double price) {
+        this->previousMatch[i] = match;
+        this->previousPrice[i] = price;
+    }
+    
+    TrackerBank::PreviousMatch TrackerBank::getPreviousMatch(size_t i) const {
+        return (PreviousMatch) this->previousMatch[i];
+    }
+    
+    double TrackerBank::getPreviousPrice(size_t i) const {
+        return this->previousPrice[i];
+    }
+    
+    void TrackerBank::latestTrackingOutputs(long minLifetime, std::vector<OT::TrackingOutput>& outputs) {
+        this->outputTrackers.clear();
+        for (size_t i = 0; i < this->size(); i++) {
+            if (this->lifetime[i] > minLifetime) {
+                this->outputTrackers.push_back((int) i);
+            }
+        }
+        
+        // Each output goes in its own place, so the ranges can fill them in any order.
+        size_t first = outputs.size();
+        outputs.resize(first + this->outputTrackers.size());
+        this->forEachRange(this->outputTrackers.size(), [this, &outputs, first](size_t start, size_t end) {
+            for (size_t k = start; k < end; k++) {
+                outputs[first + k] = this->latestTrackingOutput(this->outputTrackers[k]);
+            }
+        });
+    }
+    
+    void TrackerBank::setMinParallelTrackers(size_t minParallelTrackers) {
+        this->minParallelTrackers = minParallelTrackers;
+    }
+    
+    OT::TrackingOutput TrackerBank::latestTrackingOutput(size_t i) const {
+        return OT::TrackingOutput{
+            this->id[i],
+            this->prediction[i],
+            this->color[i],
+            this->lifetime[i],
+            this->trajectory[i].view()
+        };
+    }
+}
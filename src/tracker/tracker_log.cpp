@@ -32,6 +32,10 @@ namespace OT {
         this->numFrames = std::max(this->numFrames, frameNumber);
     }
     
+    void TrackerLog::addTrack(const OT::TrackingOutput& output, long frameNumber) {
+        this->addTrack(output.id, output.location.x, output.location.y, frameNumber);
+    }
+    
     void TrackerLog::logToFile(std::ofstream& outputStream) {
         // Sort the trackers by birth frame number.
         nlohmann::json json;
@@ -0,0 +1,84 @@
+#include "utils/allocation_counter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace OT {
+    namespace AllocationCounter {
+        // Every thread adds to the same count. Nothing else is ordered by it, so the increments
+        // are relaxed.
+        static std::atomic<long> numAllocations(0);
+        
+        bool isCounting() {
+            return true;
+        }
+        
+        long count() {
+            return numAllocations.load(std::memory_order_relaxed);
+        }
+        
+        // Allocate from malloc and count it, like the default operator new.
+        static void* allocate(std::size_t size) {
+            numAllocations.fetch_add(1, std::memory_order_relaxed);
+            void* memory = std::malloc(size == 0 ? 1 : size);
+            while (memory == nullptr) {
+                std::new_handler handler = std::get_new_handler();
+                if (handler == nullptr) {
+                    throw std::bad_alloc();
+                }
+                handler();
+                memory = std::malloc(size == 0 ? 1 : size);
+            }
+            return memory;
+        }
+        
+        static void* allocateNoThrow(std::size_t size) noexcept {
+            try {
+                return allocate(size);
+            } catch (...) {
+                return nullptr;
+            }
+        }
+    }
+}
+
+void* operator new(std::size_t size) {
+    return OT::AllocationCounter::allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return OT::AllocationCounter::allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return OT::AllocationCounter::allocateNoThrow(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return OT::AllocationCounter::allocateNoThrow(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
@@ -0,0 +1,14 @@
+#include "utils/allocation_counter.hpp"
+
+namespace OT {
+    namespace AllocationCounter {
+        // The main program keeps the default operator new, so nothing is counted.
+        bool isCounting() {
+            return false;
+        }
+        
+        long count() {
+            return 0;
+        }
+    }
+}
@@ -35,7 +35,7 @@ namespace OT {
       }
       
       void drawTrajectory(const cv::Mat& img,
-                          const std::vector<cv::Point>& trajectory,
+                          const OT::TrajectoryView& trajectory,
                           const cv::Scalar color) {
           if (trajectory.size() < 2) {
               return;
@@ -60,6 +60,10 @@ namespace OT {
                                std::vector<cv::Vec4i>(),
                                0,
                                cv::Point());
+          }
+          
+          // There may be fewer bounding rectangles than contours, since nearby contours are merged.
+          for (size_t i = 0; i < boundingRect.size(); i++) {
               OT::DrawUtils::drawBoundingRect(drawing, boundingRect[i]);
           }
           cv::imshow(drawingName, drawing);
@@ -0,0 +1,178 @@
+#include "utils/frame_transformer.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "utils/utils.hpp"
+#include "utils/perspective_transformer.hpp"
+
+namespace OT {
+    /**
+     * The matrix that maps pixel coordinates in an image of size "from" to those in the
+     * same image resized to "to". This uses the same pixel center convention as cv::resize.
+     */
+    cv::Mat scaleMatrix(cv::Size from, cv::Size to) {
+        double sx = (1.0 * to.width) / from.width;
+        double sy = (1.0 * to.height) / from.height;
+        return (cv::Mat_<double>(3, 3) <<
+                sx, 0, 0.5 * sx - 0.5,
+                0, sy, 0.5 * sy - 0.5,
+                0, 0, 1);
+    }
+    
+    FrameTransformer::FrameTransformer(const std::vector<int>& perspectivePoints,
+                                       int maxDimension,
+                                       bool warpDetections,
+                                       bool luma) {
+        this->maxDimension = maxDimension;
+        this->luma = luma;
+        
+        // Get the perspective transform, if there is one.
+        std::vector<cv::Point2f> points;
+        OT::Perspective::extractFourPoints(perspectivePoints, points);
+        this->hasPerspective = !points.empty();
+        this->warpDetections = warpDetections && this->hasPerspective;
+        if (this->hasPerspective) {
+            this->perspectiveMatrix = OT::Perspective::getPerspectiveMatrix(points, this->perspectiveSize);
+            this->outputSize = OT::Utils::scaledSize(this->perspectiveSize, maxDimension);
+            if (!this->warpDetections) {
+                this->buildRemapTables();
+            }
+        }
+    }
+    
+    void FrameTransformer::buildRemapTables() {
+        // For each output pixel, find the input pixel it comes from.
+        cv::Mat scale = scaleMatrix(this->perspectiveSize, this->outputSize);
+        cv::Mat_<double> inverse = cv::Mat(scale * this->perspectiveMatrix).inv();
+        cv::Mat mapX(this->outputSize, CV_32FC1);
+        cv::Mat mapY(this->outputSize, CV_32FC1);
+        for (int y = 0; y < this->outputSize.height; y++) {
+            float* xs = mapX.ptr<float>(y);
+            float* ys = mapY.ptr<float>(y);
+            for (int x = 0; x < this->outputSize.width; x++) {
+                double w = inverse(2, 0) * x + inverse(2, 1) * y + inverse(2, 2);
+                w = w != 0 ? 1.0 / w : 0;
+                xs[x] = (inverse(0, 0) * x + inverse(0, 1) * y + inverse(0, 2)) * w;
+                ys[x] = (inverse(1, 0) * x + inverse(1, 1) * y + inverse(1, 2)) * w;
+            }
+        }
+        
+        // Convert to fixed point, which is what cv::remap is fastest with.
+        cv::convertMaps(mapX, mapY, this->mapXY, this->mapInterpolation, CV_16SC2);
+    }
+    
+    void FrameTransformer::transform(const cv::Mat& frame, cv::Mat& output) {
+        // When we only keep luma, we convert after shrinking the frame, since it's cheaper.
+        // Frames that are already gray go straight into the output, so queued outputs
+        // never share colorFrame.
+        bool convert = this->luma && frame.channels() == 3;
+        cv::Mat& transformed = convert ? this->colorFrame : output;
+        
+        cv::Size size = OT::Utils::scaledSize(frame.size(), this->maxDimension);
+        if (this->hasPerspective && !this->warpDetections) {
+            cv::remap(frame, transformed, this->mapXY, this->mapInterpolation, cv::INTER_LINEAR);
+        } else if (size == frame.size()) {
+            // Without a perspective transform, scaling is already a single pass.
+            transformed = frame;
+        } else {
+            cv::resize(frame, transformed, size);
+        }
+        
+        if (convert) {
+            cv::cvtColor(transformed, output, CV_BGR2GRAY);
+        }
+        
+        // Once we know how big the frames are, we know how to map detections.
+        if (this->warpDetections && this->detectionMatrix.empty()) {
+            cv::Mat unscale = scaleMatrix(size, frame.size());
+            cv::Mat scale = scaleMatrix(this->perspectiveSize, this->outputSize);
+            this->detectionMatrix = scale * this->perspectiveMatrix * unscale;
+            this->detectionMatrixInverse = this->detectionMatrix.inv();
+        }
+    }
+    
+    void FrameTransformer::transformDetections(std::vector<cv::Point2f>& massCenters,
+                                               std::vector<cv::Rect>& boundingBoxes) {
+        if (!this->warpDetections || massCenters.empty()) {
+            return;
+        }
+        
+        // Transform the mass centers.
+        cv::perspectiveTransform(massCenters, massCenters, this->detectionMatrix);
+        
+        // Transform the four corners of each bounding box.
+        this->corners.clear();
+        for (auto box : boundingBoxes) {
+            this->corners.push_back(cv::Point2f(box.x, box.y));
+            this->corners.push_back(cv::Point2f(box.x + box.width, box.y));
+            this->corners.push_back(cv::Point2f(box.x + box.width, box.y + box.height));
+            this->corners.push_back(cv::Point2f(box.x, box.y + box.height));
+        }
+        cv::perspectiveTransform(this->corners, this->corners, this->detectionMatrix);
+        
+        // The boxes become the bounding boxes of their transformed corners, and we drop anything
+        // that would not have been in the perspective transformed frame.
+        cv::Rect bounds(0, 0, this->outputSize.width, this->outputSize.height);
+        size_t numKept = 0;
+        for (size_t i = 0; i < massCenters.size(); i++) {
+            if (!bounds.contains(massCenters[i])) {
+                continue;
+            }
+            float minX = this->corners[4 * i].x, maxX = this->corners[4 * i].x;
+            float minY = this->corners[4 * i].y, maxY = this->corners[4 * i].y;
+            for (size_t j = 1; j < 4; j++) {
+                minX = std::min(minX, this->corners[4 * i + j].x);
+                maxX = std::max(maxX, this->corners[4 * i + j].x);
+                minY = std::min(minY, this->corners[4 * i + j].y);
+                maxY = std::max(maxY, this->corners[4 * i + j].y);
+            }
+            massCenters[numKept] = massCenters[i];
+            boundingBoxes[numKept] = cv::Rect(cv::Point(minX, minY), cv::Point(maxX, maxY)) & bounds;
+            numKept++;
+        }
+        massCenters.resize(numKept);
+        boundingBoxes.resize(numKept);
+    }
+    
+    cv::Rect FrameTransformer::rectToFrame(const cv::Rect& rect) const {
+        if (!this->warpDetections || this->detectionMatrixInverse.empty()) {
+            return rect;
+        }
+        std::vector<cv::Point2f> rectCorners = {
+            cv::Point2f(rect.x, rect.y),
+            cv::Point2f(rect.x + rect.width, rect.y),
+            cv::Point2f(rect.x + rect.width, rect.y + rect.height),
+            cv::Point2f(rect.x, rect.y + rect.height)
+        };
+        cv::perspectiveTransform(rectCorners, rectCorners, this->detectionMatrixInverse);
+        std::vector<cv::Point> rounded(rectCorners.cbegin(), rectCorners.cend());
+        return cv::boundingRect(rounded);
+    }
+    
+    void FrameTransformer::rectify(const cv::Mat& frame, cv::Mat& output) const {
+        cv::Mat color = frame;
+        if (frame.channels() == 1) {
+            cv::cvtColor(frame, color, CV_GRAY2BGR);
+        }
+        if (!this->warpDetections || this->detectionMatrix.empty()) {
+            output = color;
+            return;
+        }
+        cv::warpPerspective(color, output, this->detectionMatrix, this->outputSize);
+    }
+    
+    cv::Size FrameTransformer::detectionSize(cv::Size frameSize) const {
+        return this->warpDetections ? this->outputSize : frameSize;
+    }
+    
+    bool FrameTransformer::hasPerspectiveTransform() const {
+        return this->hasPerspective;
+    }
+    
+    bool FrameTransformer::isWarpingDetections() const {
+        return this->warpDetections;
+    }
+}
@@ -4,29 +4,37 @@
 
 namespace OT {
     namespace Utils {
-        bool hasFrame(cv::VideoCapture& capture) {
-            bool hasNotQuit = ((char) cv::waitKey(1)) != 'q';
+        bool hasFrame(cv::VideoCapture& capture, bool headless) {
+            bool hasNotQuit = headless || ((char) cv::waitKey(1)) != 'q';
             bool hasAnotherFrame = capture.grab();
             return hasNotQuit && hasAnotherFrame;
         }
         
         void scale(cv::Mat& img, int maxDimension) {
-            if (maxDimension == -1) {
+            cv::Size newSize = scaledSize(img.size(), maxDimension);
+            if (newSize == img.size()) {
                 return;
             }
-            if (maxDimension >= img.rows && maxDimension >= img.cols) {
-                return;
+            cv::resize(img, img, newSize);
+        }
+        
+        cv::Size scaledSize(cv::Size size, int maxDimension) {
+            if (maxDimension == -1) {
+                return size;
+            }
+            if (maxDimension >= size.height && maxDimension >= size.width) {
+                return size;
             }
             
-            double scale = (1.0 * maxDimension) / img.rows;
-            if (img.cols > img.rows) {
-                scale = (1.0 * maxDimension) / img.cols;
+            double scale = (1.0 * maxDimension) / size.height;
+            if (size.width > size.height) {
+                scale = (1.0 * maxDimension) / size.width;
             }
             
-            int newRows = img.rows * scale;
-            int newCols = img.cols * scale;
+            int newRows = size.height * scale;
+            int newCols = size.width * scale;
             
-            cv::resize(img, img, cv::Size(newCols, newRows));
+            return cv::Size(newCols, newRows);
         }
     }
 }